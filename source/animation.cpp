@@ -1,30 +1,458 @@
 #include "animation.h"
 
+#include <chrono>             // std::chrono
+#include <mutex>              // std::mutex, std::lock_guard, std::unique_lock
+#include <condition_variable> // std::condition_variable
+#include "libs/keyboard.h"    // Keyboard
+#include "libs/profiler.h"    // Profiler
+
 /**
  * @brief Plays the animation frame by frame at the specified framerate
  * 
  * @param fps The frames per second at which to play the animation
  * @param n_bars The number of bars to display in each frame
  * 
- * @details The function iterates through all frames in the animation, rendering each one
- * and introducing a delay between frames to achieve the desired framerate.
+ * @details The function iterates through all frames in the animation, rendering and
+ * displaying each one when it is due according to a FrameScheduler. Frames that are
+ * already late when their turn comes are dropped, but for the last one. A summary of the frame timings is
+ * printed at the end.
  * If categories are defined and their number is 15 or less, it renders the frame with categories.
  * Otherwise, it renders the frame without category information.
  * 
- * The delay between frames is calculated as 1000/fps milliseconds.
+ * If the frames were rendered by prerenderAll(), they are only written out. If a render-ahead
+ * window is set, a background thread renders the frames while this one writes them.
  */
 void AnimationManager::PlayAnimation(int fps, int n_bars) {
+  if (not rendered.empty()) {
+    PlayRendered(rendered, fps);
+    return;
+  }
+
+  FrameScheduler scheduler(fps);
+  layout.fitTerminal();
+  // Save cursor position
+  cout << "\033[s";
+
+  if (render_ahead == 0) {
+    bool first = true;
+    auto play = [&] (Frame &frame) {
+      scheduler.startFrame();
+      std::string_view frame_text = renderFrame(frame, n_bars);
+      scheduler.endRender();
+      showFrame(frame_text, scheduler, first);
+      first = false;
+    };
+    // The last frame is never dropped, so the animation always ends on it. A late frame is
+    // only dropped once the next one exists, and is kept until then.
+    Frame late_frame;
+    bool has_late = false;
+    forEachFrame([&] (Frame &frame) {
+      if (has_late) {
+        scheduler.drop();
+        has_late = false;
+      }
+      if (scheduler.late()) {
+        late_frame.copyMeta(frame);
+        late_frame.copyBars(frame);
+        has_late = true;
+        return;
+      }
+      play(frame);
+    }, [&] () {
+      // A live stream that runs dry may have sent its last frame for a while.
+      if (live and has_late) {
+        play(late_frame);
+        has_late = false;
+      }
+      if (live) scheduler.resume();
+    });
+    if (has_late) play(late_frame);
+  } else {
+    BoundedQueue<string> ahead(render_ahead);
+    std::thread renderer([&] () {
+      forEachFrame([&] (Frame &frame) { ahead.push(string(renderFrame(frame, n_bars))); });
+      ahead.close();
+    });
+
+    string frame_text;
+    bool first = true, waited;
+    while (true) {
+      scheduler.startFrame();
+      if (not ahead.pop(frame_text, waited)) break;
+      if (waited and live) scheduler.resume();
+      if (scheduler.late()) {
+        // The last frame is never dropped, so the animation always ends on it. A live stream
+        // may not have its next frame for a while, so the late one is shown if it is not
+        // there yet: the next pop then waits for it and resumes the schedule.
+        bool has_next = live ? not ahead.empty() : not ahead.drained();
+        if (has_next) {
+          scheduler.drop();
+          continue;
+        }
+      }
+      // Waiting for the renderer counts as rendering time.
+      scheduler.endRender();
+      showFrame(frame_text, scheduler, first);
+      first = false;
+    }
+    renderer.join();
+  }
+  cout << screen.finish();
+  scheduler.printSummary(cout);
+}
+
+/**
+ * @brief Plays frames that were already rendered at the specified framerate
+ * 
+ * Frames are paced and dropped the same way as in PlayAnimation().
+ * 
+ * @param cache The rendered frames, from prerenderAll() or from a cache file
+ * @param fps The frames per second at which to play the animation
+ */
+void AnimationManager::PlayRendered(const FrameCache &cache, int fps) {
+  FrameScheduler scheduler(fps);
+  layout.fitTerminal();
   // Save cursor position
   cout << "\033[s";
+  for (size_t i = 0; i < cache.size(); i++) {
+    // The last frame is never dropped, so the animation always ends on it.
+    if (i + 1 < cache.size() and scheduler.late()) {
+      scheduler.drop();
+      continue;
+    }
+    scheduler.startFrame();
+    scheduler.endRender();
+    showFrame(cache[i], scheduler, i == 0);
+  }
+  cout << screen.finish();
+  scheduler.printSummary(cout);
+}
+
+/**
+ * @brief Renders every frame as fast as possible and hands them to an exporter, in order
+ * 
+ * n_jobs threads render the frames (with their in-between frames, if any) while this one
+ * writes them out. Renderers never get more than a few frames ahead of the writer, so
+ * memory does not grow with the number of frames. Nothing waits for the frames' turn.
+ * 
+ * @param exporter Where the frames are written, already open
+ * @param n_bars The number of bars to display in each frame
+ * @param n_jobs The number of rendering threads
+ * 
+ * @note Not available in streaming mode, where frames are not kept.
+ */
+void AnimationManager::ExportAnimation(FrameExporter &exporter, int n_bars, unsigned n_jobs) {
+  n_jobs = std::max(1u, n_jobs);
+  const size_t n_frames = numberCharts();
+  const size_t window = 4 * n_jobs;           // Frames rendered ahead of the one written
+  std::vector<std::vector<string>> slots(window); // Rendered frames, by index % window
+  std::vector<bool> ready(window, false);
+  size_t next_frame = 0, n_written = 0;
+  std::mutex mutex;
+  std::condition_variable changed;
+
+  auto worker = [&] () {
+    StyledBuffer out;
+    Layout worker_layout; // Exported frames do not depend on the terminal
+    Tweener worker_tweener;
+    Frame previous_decoded, current_decoded;
+    FrameStore::Cursor previous_cursor, current_cursor;
+    auto frame_at = [this] (size_t i, Frame &decoded, FrameStore::Cursor &cursor) -> Frame& {
+      if (store) return store->read(i, cursor);
+      if (not compiled.isOpen()) return *frames[i];
+      compiled.readFrame(i, decoded);
+      return decoded;
+    };
+
+    while (true) {
+      size_t i;
+      {
+        std::unique_lock lock(mutex);
+        changed.wait(lock, [&] { return next_frame >= n_frames or next_frame < n_written + window; });
+        if (next_frame >= n_frames) return;
+        i = next_frame++;
+      }
+
+      std::vector<string> rendered_frames;
+      Frame &frame = frame_at(i, current_decoded, current_cursor);
+      if (tween_steps > 0 and i > 0) {
+        // Rendering only reorders a frame's bars, so reading the previous one here is safe.
+        worker_tweener.push(frame_at(i - 1, previous_decoded, previous_cursor));
+        worker_tweener.push(frame);
+        for (int step = 1; step <= tween_steps; step++) {
+          rendered_frames.emplace_back(renderFrame(worker_tweener.at(double(step) / (tween_steps + 1)), n_bars, out, worker_layout));
+        }
+      }
+      rendered_frames.emplace_back(renderFrame(frame, n_bars, out, worker_layout));
+
+      std::lock_guard lock(mutex);
+      slots[i % window] = std::move(rendered_frames);
+      ready[i % window] = true;
+      changed.notify_all();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < n_jobs; i++) threads.emplace_back(worker);
+
+  for (size_t i = 0; i < n_frames; i++) {
+    std::vector<string> rendered_frames;
+    {
+      std::unique_lock lock(mutex);
+      changed.wait(lock, [&] { return bool(ready[i % window]); });
+      rendered_frames = std::move(slots[i % window]);
+      ready[i % window] = false;
+      n_written = i + 1;
+      changed.notify_all();
+    }
+    for (const string &frame : rendered_frames) exporter.write(frame);
+  }
+  for (auto &thread : threads) thread.join();
+}
+
+/**
+ * @brief Renders every frame ahead of time, so playing them only has to write them out
+ * 
+ * In streaming mode this reads the whole stream, so it defeats its purpose.
+ * 
+ * @param n_bars The number of bars to display in each frame
+ */
+void AnimationManager::prerenderAll(int n_bars) {
+  layout.fitTerminal();
+  forEachFrame([&] (Frame &frame) { rendered.add(string(renderFrame(frame, n_bars))); });
+}
+
+/**
+ * @brief Calls action on every frame, in order. In streaming mode frames are dropped right after.
+ * 
+ * Frames of a compiled dataset or of the store are decoded one at a time into the same Frame.
+ * 
+ * If tweening is enabled, action is also called on the in-between frames that lead to each
+ * frame but the first, right before it.
+ * 
+ * In streaming mode, on_wait (if any) is called whenever a frame had to be waited for.
+ */
+void AnimationManager::forEachFrame(const std::function<void(Frame&)> &action, const std::function<void()> &on_wait) {
+  bool first = true;
+  auto play = [&] (Frame &frame) {
+    if (tween_steps > 0) {
+      tweener.push(frame);
+      for (int step = 1; not first and step <= tween_steps; step++) {
+        action(tweener.at(double(step) / (tween_steps + 1)));
+      }
+      first = false;
+    }
+    action(frame);
+  };
+
+  if (stream) {
+    std::unique_ptr<Frame> frame;
+    bool waited;
+    while (stream->pop(frame, waited)) {
+      if (waited and on_wait) on_wait();
+      registerCategories(*frame);
+      play(*frame);
+    }
+    return;
+  }
+  if (compiled.isOpen()) {
+    Frame frame;
+    for (size_t i = 0; i < compiled.size(); i++) {
+      compiled.readFrame(i, frame);
+      play(frame);
+    }
+    return;
+  }
+  if (store) {
+    FrameStore::Cursor store_cursor;
+    for (size_t i = 0; i < store->size(); i++) play(store->read(i, store_cursor));
+    return;
+  }
+  for (auto &frame : frames) play(*frame);
+}
+
+/// Renders a frame into out with a layout, with category colors if there are between 1 and 15 categories.
+/// @return The rendered frame, valid until out is used again
+std::string_view AnimationManager::renderFrame(Frame &frame, int n_bars, StyledBuffer &out, Layout &frame_layout) const {
+  out.clear();
+  if (categories.empty() or categories.size() > 15) frame.render(out, symbols, frame_layout, n_bars);
+  else frame.render(out, symbols, categories, frame_layout, n_bars);
+  return out.finish();
+}
+
+/// Writes a rendered frame over the previous one (if any) and waits for the next one's turn.
+void AnimationManager::showFrame(std::string_view frame, FrameScheduler &scheduler, bool first) {
+  drawFrame(frame, first);
+  scheduler.endWrite();
+  Profiler::Scope scope(Profiler::WAIT);
+  scheduler.waitForNextFrame();
+}
+
+/**
+ * @brief Writes a rendered frame over the previous one, if any
+ * 
+ * After the terminal was resized, its lines may have been rewrapped and the saved cursor
+ * position is meaningless, so the screen is cleared and the frame is drawn from its top.
+ */
+void AnimationManager::drawFrame(std::string_view frame, bool first) {
+  Profiler::Scope scope(Profiler::WRITE);
+  Profiler::add(Profiler::FRAMES_SHOWN);
+  if (Layout::resizeCount() != drawn_resizes) {
+    drawn_resizes = Layout::resizeCount();
+    if (not first) {
+      cout << "\033[H\033[2J\033[s";
+      screen.reset();
+    }
+  }
+  if (diff_output) {
+    cout << screen.update(frame) << std::flush;
+  } else {
+    // Restore cursor position & clear screen, so the last frame stays on screen
+    if (not first) cout << "\033[u\033[J";
+    cout << frame << std::flush;
+  }
+}
+
+/// Opens a compiled dataset and indexes its timestamps.
+bool AnimationManager::openCompiled(const string &path) {
+  if (not compiled.open(path, symbols, categories)) return false;
+  for (size_t i = 0; i < compiled.size(); i++) indexTimestamp(compiled.timestampOf(i), i);
+  return true;
+}
 
-  int n_frames = frames.size();
-  for (int i = 0; i < n_frames; ++i) {
-    auto &frame = frames[i];
-    if (categories.empty() or categories.size() > 15) cout << frame->render(n_bars);
-    else cout << frame->render(categories,n_bars);
+/// Returns the i-th frame, decoding it if it comes from a compiled dataset or the store.
+/// @note Not available in streaming mode, where frames are not kept.
+Frame &AnimationManager::frameAt(size_t i) {
+  if (store) return store->read(i, cursor);
+  if (not compiled.isOpen()) return *frames[i];
+  compiled.readFrame(i, decoded);
+  return decoded;
+}
+
+/**
+ * @brief Finds the first frame of a timestamp
+ * 
+ * @param timestamp The timestamp to look for
+ * @return The first frame of the timestamp or, if there is none, of the first timestamp
+ *         that comes after it in alphabetical order (the last frame if none does)
+ * 
+ * Time Complexity: O(log t) where t is the number of distinct timestamps
+ */
+size_t AnimationManager::findTimestamp(std::string_view timestamp) const {
+  auto found = timestamps.lower_bound(timestamp);
+  if (found == timestamps.end()) return numberCharts() > 0 ? numberCharts() - 1 : 0;
+  return found->second;
+}
+
+/**
+ * @brief Plays the animation under the control of the keyboard
+ * 
+ * The animation starts playing at the specified framerate and can be paused, resumed,
+ * stepped back and forth, sped up, slowed down and moved to any timestamp. Keys are read
+ * while waiting for the next frame, so they take effect right away. Only the frames of the
+ * input are shown (no in-between frames), and the animation pauses on the last one until
+ * it is quit.
+ * 
+ * Falls back to PlayAnimation() if the standard input is not a terminal.
+ * 
+ * @param fps The frames per second at which the animation starts
+ * @param n_bars The number of bars to display in each frame
+ */
+void AnimationManager::PlayInteractive(int fps, int n_bars) {
+  Keyboard keyboard;
+  if (not keyboard.enableRaw()) {
+    Logger::logWarning1("The input is not a terminal, so the animation cannot be controlled. Playing it from start to end.\n");
+    PlayAnimation(fps, n_bars);
+    return;
+  }
+
+  using clock = std::chrono::steady_clock;
+  constexpr int MAX_FPS = 96;
+  const size_t n_frames = numberCharts();
+  if (n_frames == 0) return;
+
+  auto period = [&fps] { return std::chrono::duration_cast<clock::duration>(std::chrono::seconds(1)) / fps; };
+  size_t current = 0;
+  bool paused = false, quit = false, redraw = true, first = true;
+  clock::time_point next_frame = clock::now() + period();
+  string screen_text;
+
+  layout.fitTerminal();
+  // Save cursor position
+  cout << "\033[s";
+  while (not quit) {
+    if (Layout::resizeCount() != drawn_resizes) redraw = true;
+    if (redraw) {
+      Frame &frame = frameAt(current);
+      screen_text = renderFrame(frame, n_bars);
+      screen_text += ">>> " + string(paused ? "Paused" : "Playing") + " at chart " + std::to_string(current + 1)
+                   + "/" + std::to_string(n_frames) + " (" + string(symbols.name(frame.getTimestamp()))
+                   + "), " + std::to_string(fps) + " fps\n";
+      screen_text += ">>> space: play/pause, <-/->: step, +/-: speed, Home/End, g: go to timestamp, q: quit\n";
+      drawFrame(screen_text, first);
+      first = redraw = false;
+    }
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(1000 / fps));
-    // Restore cursor position & clear screen (Unless we rendered the last frame)
-    if (i < n_frames-1) cout << "\033[u\033[J";
+    auto timeout = paused ? std::chrono::milliseconds(1000)
+                          : std::chrono::duration_cast<std::chrono::milliseconds>(next_frame - clock::now());
+    int key = keyboard.waitKey(timeout);
+    switch (key) {
+      case Keyboard::NONE:
+        if (paused or clock::now() < next_frame) break;
+        if (current + 1 < n_frames) current++;
+        else paused = true;
+        // A late frame is not caught up with, the next one is a whole period away.
+        next_frame = std::max(next_frame + period(), clock::now());
+        redraw = true;
+        break;
+      case ' ':
+        paused = not paused;
+        if (not paused and current + 1 == n_frames) current = 0;
+        next_frame = clock::now() + period();
+        redraw = true;
+        break;
+      case Keyboard::RIGHT: case 'l':
+        paused = true;
+        if (current + 1 < n_frames) current++;
+        redraw = true;
+        break;
+      case Keyboard::LEFT: case 'h':
+        paused = true;
+        if (current > 0) current--;
+        redraw = true;
+        break;
+      case Keyboard::UP: case '+':
+        fps = std::min(fps * 2, MAX_FPS);
+        redraw = true;
+        break;
+      case Keyboard::DOWN: case '-':
+        fps = std::max(fps / 2, 1);
+        redraw = true;
+        break;
+      case Keyboard::HOME:
+        current = 0;
+        redraw = true;
+        break;
+      case Keyboard::END:
+        current = n_frames - 1;
+        redraw = true;
+        break;
+      case 'g': {
+        cout << screen.finish() << ">>> Go to timestamp: " << std::flush;
+        string timestamp = keyboard.readLine();
+        // Erase the prompt, which is below the chart.
+        cout << "\033[A\r\033[J";
+        current = findTimestamp(timestamp);
+        paused = true;
+        redraw = true;
+        break;
+      }
+      case 'q': case 3: // Ctrl+C
+        quit = true;
+        break;
+      default:
+        break;
+    }
   }
-}
\ No newline at end of file
+  cout << screen.finish() << std::flush;
+}
@@ -1,31 +1,178 @@
 #pragma once
 
-#include <thread>       // std::this_thread::sleep_for
-#include <chrono>       // std::chrono::milliseconds
-#include <memory>       // std::unique_ptr
-#include <iostream>     // std::cout
-#include <map>          // std::map
-#include <string>       // std::string
-#include <vector>       // std::vector
-#include "barchart.h"   // Frame
+#include <thread>           // std::thread
+#include <functional>       // std::function
+#include <memory>           // std::unique_ptr
+#include <iostream>         // std::cout
+#include <string>           // std::string
+#include <string_view>      // std::string_view
+#include <vector>           // std::vector
+#include <map>              // std::map
+#include <atomic>           // std::atomic
+#include "barchart.h"       // Frame
+#include "bounded_queue.h"  // BoundedQueue
+#include "frame_cache.h"    // FrameCache
+#include "compiled_dataset.h" // CompiledDataset
+#include "frame_store.h"    // FrameStore
+#include "frame_export.h"   // FrameExporter
+#include "frame_scheduler.h" // FrameScheduler
+#include "symbol_table.h"   // SymbolTable
+#include "palette.h"        // Palette
+#include "screen.h"         // Screen
+#include "tween.h"          // Tweener
+#include "ranker.h"         // Ranker
+#include "gap_filler.h"     // GapFiller
+#include "layout.h"         // Layout
 
 using std::cout;
 
+using FrameQueue = BoundedQueue<std::unique_ptr<Frame>>;
+
+/**
+ * @brief Holds the frames of the animation and plays them.
+ * 
+ * By default every frame is kept until the animation is played. In streaming mode frames
+ * go through a bounded FrameQueue instead: they can be played while the input is still
+ * being read, and each one is dropped as soon as it was displayed.
+ * 
+ * Frames can also come from a CompiledDataset, in which case they are decoded from the
+ * compiled file one at a time as they are played. Frames kept in memory can be compressed
+ * into a FrameStore, in which case they are likewise decoded one at a time.
+ * 
+ * Frames are normally rendered right before being displayed. They can also be rendered
+ * ahead of time: either all of them, into a FrameCache, or a window of them on a
+ * background thread while the animation plays.
+ * 
+ * Between two consecutive frames, a number of in-between frames can be played to make the
+ * bars move smoothly. They are made by a Tweener right when they are needed, so they take
+ * no extra memory.
+ * 
+ * Frames kept in memory or in a compiled dataset can also be played interactively, moving
+ * back and forth between them. Every timestamp is indexed as frames are added, so any of
+ * them can be reached in O(log n).
+ * 
+ * A live stream (e.g. a file followed as it grows) can run dry for any amount of time, so
+ * the animation waits for its next frame and resumes from there instead of dropping it.
+ * 
+ * Each frame either replaces the whole previous one on the terminal or, with differential
+ * output enabled, only the cells that changed, which writes much less and avoids flicker.
+ * 
+ * Frames played on the terminal are laid out to fit its width, and again whenever it is
+ * resized, in which case the next frame is drawn from scratch. Frames written elsewhere
+ * (exported, or to a file) keep the default geometry.
+ * 
+ * Frames played in order are ranked from the ranking of the previous one, which is much
+ * cheaper than sorting them when bars only overtake a few others at a time.
+ * 
+ * Frames of a sparse input can get the entities they do not list filled in as they are
+ * added, with their last known value or a decaying one, so bars do not flicker in and out.
+ * 
+ * The manager also owns the SymbolTable every frame's strings are interned in, and the
+ * Palette holding the categories and their colors.
+ */
 class AnimationManager {
   vector<std::unique_ptr<Frame>> frames;  ///< Vector of frames
-  std::map<string, color_t> categories;   ///< Map of categories and colors
+  Palette categories;                     ///< Categories and their colors
+  std::unique_ptr<FrameQueue> stream;     ///< Frames waiting to be played (streaming mode only)
+  SymbolTable symbols;                    ///< Strings of every frame
+  FrameCache rendered;                    ///< Frames rendered by prerenderAll()
+  CompiledDataset compiled;               ///< Frames of a compiled dataset, used instead of frames if open
+  Frame decoded;                          ///< The last frame decoded from compiled by frameAt()
+  std::unique_ptr<FrameStore> store;      ///< Compressed frames, used instead of frames if set
+  FrameStore::Cursor cursor;              ///< Decodes the frames of store for frameAt()
+  std::map<std::string_view, size_t> timestamps; ///< First frame of each timestamp (not in streaming mode)
+  size_t render_ahead = 0;                ///< # of frames rendered ahead of the one displayed (0 disables it)
+  StyledBuffer render_buffer;             ///< Buffer every frame is rendered into
+  bool diff_output = false;               ///< Whether only the changes between frames are written
+  Screen screen;                          ///< What is on the terminal (differential output only)
+  int tween_steps = 0;                    ///< # of in-between frames played between two frames
+  Tweener tweener;                        ///< Makes the in-between frames
+  bool live = false;                      ///< Whether frames keep being added while they are played
+  Ranker ranker;                          ///< Ranks each frame from the previous one's ranking
+  Layout layout;                          ///< Geometry of the frames played, and their cached axis
+  unsigned drawn_resizes = 0;             ///< Terminal resizes already taken into account by drawFrame()
+  GapFiller gaps;                         ///< Fills the entities missing from the frames added
+  std::atomic<size_t> known_entities = 0; ///< Entities gaps knows of, read by the threads parsing frames
+
+  void registerCategories(const Frame &frame) {
+    for (symbol_t category : frame.getCategories()) addCategoryColor(category);
+  }
+  void forEachFrame(const std::function<void(Frame&)> &action, const std::function<void()> &on_wait = nullptr);
+  std::string_view renderFrame(Frame &frame, int n_bars) {
+    layout.update();
+    ranker.rank(frame, n_bars);
+    return renderFrame(frame, n_bars, render_buffer, layout);
+  }
+  std::string_view renderFrame(Frame &frame, int n_bars, StyledBuffer &out, Layout &frame_layout) const;
+  void showFrame(std::string_view frame, FrameScheduler &scheduler, bool first);
+  void drawFrame(std::string_view frame, bool first);
+  void indexTimestamp(symbol_t timestamp, size_t frame) {
+    timestamps.try_emplace(symbols.name(timestamp), frame);
+  }
 
   public:
     AnimationManager() = default;
 
-    void addFrame(std::unique_ptr<Frame> frame) { frames.push_back(std::move(frame)); }
-    void addCategoryColor(string category) { 
-      if (categories.find(category) == categories.end()) {
-        categories[category] = Colors::COLORS[categories.size()%Colors::COLORS.size()]; 
+    /// Plays frames as they are added, holding at most depth of them at a time.
+    void enableStreaming(size_t depth) { stream = std::make_unique<FrameQueue>(depth); }
+    bool streaming() const { return stream != nullptr; }
+    /// Waits for streamed frames that were not read yet instead of dropping them once they are late.
+    void setLive(bool enabled) { live = enabled; }
+    /// Keeps the frames added compressed, with a keyframe every keyframe_interval frames.
+    void enableCompression(size_t keyframe_interval) { store = std::make_unique<FrameStore>(keyframe_interval); }
+    const FrameStore *getStore() const { return store.get(); }
+    /// Number of bars a frame added next has once filled, but for entities seen for the first time.
+    /// 0 if the frames are not filled.
+    size_t knownEntities() const { return known_entities.load(std::memory_order_relaxed); }
+    /// Fills the frames added with the entities they are missing, carried forward or decayed.
+    void setGapFilling(GapFiller::Mode mode, double decay = GapFiller::DEFAULT_DECAY) { gaps = GapFiller(mode, decay); }
+    /// Signals that no more frames will be added (streaming mode only).
+    void endOfStream() { if (stream) stream->close(); }
+    /// Renders frames on a background thread, up to n_frames ahead of the one displayed.
+    void setRenderAhead(size_t n_frames) { render_ahead = n_frames; }
+    /// Plays n_steps in-between frames between each pair of consecutive frames.
+    void setTweenSteps(int n_steps) { tween_steps = n_steps; }
+    /// Writes only the cells that changed since the previous frame instead of the whole frame.
+    void setDiffOutput(bool enabled) { diff_output = enabled; }
+
+    /// Stores a frame, registering the categories of its bars in the order they were read.
+    /// @note Frames must be added in order, by a single thread at a time.
+    void addFrame(std::unique_ptr<Frame> frame) {
+      if (gaps.enabled()) {
+        gaps.fill(*frame);
+        known_entities.store(gaps.size(), std::memory_order_relaxed);
+      }
+      if (stream) {
+        // Categories are registered by the thread rendering the frames, which is the one reading them.
+        stream->push(std::move(frame));
+        return;
+      }
+      registerCategories(*frame);
+      if (store) {
+        indexTimestamp(frame->getTimestamp(), store->size());
+        store->add(*frame);
+        return;
       }
+      indexTimestamp(frame->getTimestamp(), frames.size());
+      frames.push_back(std::move(frame));
     }
+    /// Plays the frames of a compiled dataset. Must be called before any frame is added.
+    bool openCompiled(const string &path);
+    /// Compiles the frames added so far into a file.
+    /// @note Not available with compression, where frames are not kept as they are.
+    bool saveCompiled(const string &path) const { return CompiledDataset::save(path, symbols, categories, frames); }
+    const CompiledDataset &getCompiled() const { return compiled; }
+    void addCategoryColor(symbol_t category) { categories.assign(category); }
+    SymbolTable &getSymbols() { return symbols; }
+    Palette &getCategories() { return categories; }
+    void prerenderAll(int n_bars);
+    const FrameCache &getRendered() const { return rendered; }
     void PlayAnimation(int fps, int n_bars);
-    size_t numberCharts() { return frames.size(); }
+    void PlayRendered(const FrameCache &cache, int fps);
+    void PlayInteractive(int fps, int n_bars);
+    void ExportAnimation(FrameExporter &exporter, int n_bars, unsigned n_jobs);
+    size_t findTimestamp(std::string_view timestamp) const;
+    Frame &frameAt(size_t i);
+    size_t numberCharts() const { return compiled.isOpen() ? compiled.size() : store ? store->size() : frames.size(); }
     size_t numberCategories() { return categories.size(); }
-    //void smoothFrames(); would be cool but will not implement it right now
-};
\ No newline at end of file
+};
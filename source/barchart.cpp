@@ -1,177 +1,175 @@
 #include "barchart.h"
 
+#include "libs/profiler.h" // Profiler
+
 /**
- * @brief Sorts the bars in descending order based on their values.
+ * @brief Finds the n_top bars with the highest values, in descending order.
+ * 
+ * The bars themselves are not moved: this function fills the order vector with the
+ * bar indices and moves the indices of the n_top highest bars to its front, sorted by
+ * value with a lambda comparator. Only those bars are displayed, so the rest of the
+ * order is left unsorted, and a frame that was already ranked this far is not sorted again.
+ * Bars with the same value are ranked in the order they were added, so ties always
+ * break the same way.
  * 
- * This function sorts the internal vector of bars using std::sort with a lambda 
- * comparator that compares bar values. Bars with higher values will appear first
- * in the sorted vector.
+ * @param n_top The number of bars to rank (all of them if it exceeds the number of bars)
  * 
- * Time Complexity: O(n log n) where n is the number of bars
+ * Time Complexity: O(n log k) where n is the number of bars and k is n_top
  */
-void Frame::sortBars() {
-  
-  auto cmp = [] (const auto &a, const auto &b) {
-    return a->getValue() > b->getValue();
-  };
+void Frame::sortBars(size_t n_top) {
+  n_top = std::min(n_top, values.size());
+  if (n_ranked >= n_top) return;
+
+  if (order.size() != values.size()) {
+    order.resize(values.size());
+    for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+  }
 
-  std::sort(bars.begin(), bars.end(), cmp);
+  auto cmp = [this] (uint32_t a, uint32_t b) { return ranksBefore(a, b); };
+  if (n_top == values.size()) std::sort(order.begin(), order.end(), cmp);
+  else std::partial_sort(order.begin(), order.begin() + n_top, order.end(), cmp);
+  n_ranked = n_top;
 }
 
 /**
- * @brief Calculates and updates the visual length of all bars in the frame
- * 
- * This function calculates the relative length of each bar based on its value
- * compared to the maximum value in the frame. The length is scaled proportionally
- * to fit within the specified bar_length.
- * 
- * The calculation uses the formula: length = (value * bar_length) / max_value
- * where max_value is the value of the highest bar in the frame.
+ * @brief Finds the n_top bars with the highest values, starting from an order that is
+ * probably close to the right one.
+ * 
+ * The caller guarantees the n_top highest bars are among the first n_candidates of the
+ * seed (e.g. the bars ranked by the previous frame, plus any that now reach their values).
+ * Only those candidates are ranked, with an insertion sort, which takes O(c + m) for c
+ * candidates and m positions out of place, so it is close to linear when only a few bars
+ * overtook others. Seeds that are far off would make it quadratic, so after MAX_SEED_MOVES
+ * moves per candidate it gives up and sorts them instead. The ranking is the one
+ * sortBars() makes either way.
+ * 
+ * @param seed Every bar index, each exactly once. Receives the frame's previous order.
+ * @param n_candidates How many bars at the front of the seed may rank in the top n_top
+ * @param n_top The number of bars to rank
+ * @return false if the seed was too far off and the candidates were sorted instead
  */
-void Frame::calcLengths() {
-  int max_value = bars.front()->getValue();
-
-  for (auto &bar : bars) {
-    bar->setLength(bar->getValue() * bar_length / max_value);
+bool Frame::sortBarsFrom(vector<uint32_t> &seed, size_t n_candidates, size_t n_top) {
+  order.swap(seed);
+  n_candidates = std::min(n_candidates, order.size());
+  auto cmp = [this] (uint32_t a, uint32_t b) { return ranksBefore(a, b); };
+  size_t moves = 0;
+  const size_t max_moves = MAX_SEED_MOVES * n_candidates;
+  bool repaired = true;
+  for (size_t i = 1; i < n_candidates; i++) {
+    uint32_t bar = order[i];
+    size_t j = i;
+    for (; j > 0 and ranksBefore(bar, order[j - 1]); j--) order[j] = order[j - 1];
+    order[j] = bar;
+    moves += i - j;
+    if (moves > max_moves) {
+      n_top = std::min(n_top, n_candidates);
+      std::partial_sort(order.begin(), order.begin() + n_top, order.begin() + n_candidates, cmp);
+      repaired = false;
+      break;
+    }
   }
+  n_ranked = std::min(n_top, n_candidates);
+  return repaired;
 }
 
 /**
- * @brief Builds and returns a string representation of the X-axis for the bar chart
- * 
- * This function creates a horizontal axis with tick marks and corresponding numeric values.
- * The axis is scaled based on the maximum value of the bars and includes formatted numbers
- * (using K for thousands, M for millions, B for billions).
- * 
- * The axis consists of two parts:
- * 1. A line with '+' marks for ticks and '-' for the axis line, ending with '>'
- * 2. Numeric values aligned under each tick mark
+ * @brief Calculates and updates the visual length of the bars that are displayed
  * 
- * @return string The formatted X-axis as a string, including tick marks and values
+ * This function calculates the relative length of the n_visible highest bars based on
+ * their value compared to the maximum value in the frame. The length is scaled
+ * proportionally to fit within the specified bar_length.
  * 
- * Example output:
- * +----+----+----+----+>
- * 0    25K  50K  75K  100K
+ * The calculation uses the formula: length = (value * bar_length) / max_value
+ * where max_value is the value of the highest bar in the frame, rounded down. Bars with
+ * a value of 0 or less, and every bar if max_value is not positive, have no length.
  * 
- * @note The axis length and number of ticks are determined by class member variables
- *       axis_length and n_ticks
- * @note The scale is determined by the maximum value in the bars vector
+ * @param n_visible The number of bars displayed, which must have been ranked by sortBars()
+ * @param bar_length The length of the highest bar, in characters
  */
-string Frame::buildXAxis() const {
-  //FIXME: Fix number formatting for decimal values
-  string axis;
-  int tick_separation = (axis_length-1) / n_ticks;
-  int max_value = bars.front()->getValue();
-
-  
-  auto number_format = [] (int number) {
-    string formatted_number = std::to_string(number);
-    if (number >= (int)1e9) {
-      formatted_number = std::to_string(number / 1000000000) + "B";
-    } else if (number >= (int)1e6) {
-      int truncated = number % (int)1e6 / (int)1e4;
-      if (number < (int)1e7) formatted_number = std::to_string(number / 1000000) + "." + std::to_string((number / 10000)%100) + "M";
-      else formatted_number = std::to_string(number / 1000000) + "M";
-    } else if (number >= (int)1e3) {
-      if (number < (int)1e4) formatted_number = std::to_string(number / 1000) + "." + std::to_string((number / 10)%100) + "K";
-      else formatted_number = std::to_string(number / 1000) + "K";
-    }
-    return formatted_number;
-  };
-
-  vector<int> tick_locations;
-  vector<int> tick_values;
-  tick_values.reserve(n_ticks), tick_locations.reserve(n_ticks);
-  // Printing the Axis itself
-  axis += "+"; //Put the first tick on zero.
-  tick_locations.push_back(0);
-  tick_values.push_back(0);
-  for (int i = 1; i < axis_length; i++) {
-    if (i % tick_separation == 0) {
-      axis += "+";
-      tick_locations.push_back(i);
-      tick_values.push_back(i * max_value / bars.front()->getLength());
-    } else {
-      axis += "-";
-    }
-  }
-
-  axis += ">\n";
-
-  // Printing the values
-  int currpos = 0;
-  for (int i = 0; i < tick_locations.size(); i++) {
-    string tick_value_str = number_format(tick_values[i]);
-    int space_count = std::max(0, tick_locations[i] - currpos);
-    axis += std::string(space_count, ' ');
-    axis += tick_value_str;
-    currpos += space_count + tick_value_str.size();
+void Frame::calcLengths(size_t n_visible, int bar_length) {
+  n_visible = std::min(n_visible, n_ranked);
+  value_t max_value = values[order.front()];
+
+  lengths.resize(n_visible);
+  for (size_t rank = 0; rank < n_visible; rank++) {
+    value_t value = values[order[rank]];
+    lengths[rank] = max_value > 0 and value > 0 ? static_cast<int>(value * bar_length / max_value) : 0;
   }
-  axis += "\n";
+}
 
-  return axis;
+/**
+ * @brief Appends the X-axis of the chart, with tick marks and values scaled to its longest bar
+ * 
+ * The axis is built by the layout, which reuses it for as long as the geometry and the
+ * scale (the value and length of the longest bar) stay the same.
+ * 
+ * @param out The buffer the axis is appended to, unformatted
+ * @param layout The layout the lengths were calculated with
+ */
+void Frame::buildXAxis(StyledBuffer &out, Layout &layout) const {
+  out.appendPlain(layout.xAxis(values[order.front()], lengths.front()));
 }
 
 /**
  * @brief Renders a bar with the specified color and label
  * 
- * This function creates and outputs a bar visualization by:
- * 1. Creating a string of spaces with length specified by the Bar's length
- * 2. Applying reverse formatting with the specified color
- * 3. Appending the bar's label with the same color
- * 4. Outputting the formatted bar to standard output with a newline
+ * This function creates a bar visualization by:
+ * 1. Appending as many spaces as the bar's length, with reverse formatting in the specified color
+ * 2. Appending the bar's label and value with the same color
  *
+ * @param out The buffer the bar is appended to
+ * @param rank The position of the bar in the chart (0 for the highest bar)
+ * @param label The text of the bar's label
  * @param color The color to use for both the bar and label
  */
-string Bar::render(color_t color) const {
-  std::stringstream ss;
-  string bar = string(length, ' ');
-  ss   << TextFormat::applyFormat(bar, color, Modifiers::REVERSE)
-       << TextFormat::applyFormat(label, color) << TextFormat::applyFormat(" [", color) 
-       << TextFormat::applyFormat(std::to_string(value), color) << TextFormat::applyFormat("]", color) << "\n";
-  return ss.str();
+void Frame::renderBar(StyledBuffer &out, size_t rank, std::string_view label, color_t color) const {
+  out.appendFill(lengths[rank], ' ', color, Modifiers::REVERSE);
+  out.append(label, color);
+  out.append(" [", color);
+  out.appendDecimal(values[order[rank]], color);
+  out.append("]", color);
+  out.appendPlain("\n");
 }
 
 /**
- * @brief Renders a frame of the bar chart to standard output
+ * @brief Renders a frame of the bar chart
  * 
  * This overload renders all bars in the same color (cyan).
  * The frame includes a header with title and timestamp, the bars themselves,
  * an x-axis, and footer with x-axis label and source information.
  * 
+ * @param out The buffer the frame is appended to
+ * @param symbols The table the frame's labels, categories and metadata were interned in
+ * @param layout The geometry of the chart, and its cached axis
  * @param n_bars The maximum number of bars to render. If n_bars is greater than
  *              the actual number of bars, all bars will be rendered
  * 
  * @throws RuntimeError if the frame is empty (logged via Logger::logError1)
  * 
- * @note Bars are sorted before rendering
+ * @note Only the bars displayed are ranked, and only once per frame
  * @note All bars are rendered in cyan color
  */
-string Frame::render(int n_bars) {
+void Frame::render(StyledBuffer &out, const SymbolTable &symbols, Layout &layout, int n_bars) {
   if (empty()) {
     Logger::logError1("Cannot render an empty frame.");
-    return "";
+    return;
   }
-  std::stringstream ss;
-  // Chart Header
-  ss << "\t\t" << TextFormat::applyFormat(title, Colors::BLUE, Modifiers::BOLD) << "\n\n";
-  ss << "\t" << TextFormat::applyFormat("Time Stamp: "+timestamp, Colors::BLUE, Modifiers::BOLD) << "\n\n";
+  Profiler::Scope scope(Profiler::RENDER);
+  size_t start_size = out.size();
+  renderHeader(out, symbols);
 
   //Chart Body
-  sortBars();
+  sortBars(n_bars);
 
-  calcLengths();
+  calcLengths(n_bars, layout.getGeometry().bar_length);
   
-  for (int i = 0; i < n_bars and i < bars.size(); i++) {
-    ss << bars[i]->render(Colors::CYAN);
+  for (int i = 0; i < n_bars and i < order.size(); i++) {
+    renderBar(out, i, symbols.name(labels[order[i]]), Colors::CYAN);
   }
 
-  ss << buildXAxis();
-
-  // Chart Footer
-  ss << TextFormat::applyFormat(x_label, Colors::YELLOW, Modifiers::BOLD) << "\n\n";
-  ss << TextFormat::applyFormat(source, Colors::WHITE, Modifiers::BOLD) << "\n";
-  return ss.str();
+  buildXAxis(out, layout);
+  renderFooter(out, symbols);
+  Profiler::add(Profiler::RENDER_BYTES, out.size() - start_size);
 }
 
 /**
@@ -181,46 +179,67 @@ string Frame::render(int n_bars) {
  * the bars themselves, x-axis, footer (x-label and source), and a color caption.
  * Bars are colored according to their category using the provided category-color mapping.
  * 
- * @param categories Map associating each category name with its corresponding color
+ * @param out The buffer the frame is appended to
+ * @param symbols The table the frame's labels, categories and metadata were interned in
+ * @param palette The categories' names and colors
+ * @param layout The geometry of the chart, and its cached axis
  * @param n_bars Maximum number of bars to display (will display fewer if frame contains less bars)
  * 
  * @throws Logger::Error1 if the frame is empty
  * 
- * @note Bars are automatically sorted before rendering
+ * @note Only the bars displayed are ranked, and only once per frame
  * @note If n_bars is greater than the actual number of bars, all bars will be displayed
  */
-string Frame::render(std::map<string,color_t>& categories, int n_bars) {
+void Frame::render(StyledBuffer &out, const SymbolTable &symbols, const Palette &palette, Layout &layout, int n_bars) {
   if (empty()) {
     Logger::logError1("Cannot render an empty frame.");
-    return "";
-  } else if (categories.size() > 15) {
-    return render(n_bars);
+    return;
+  } else if (palette.size() > 15) {
+    render(out, symbols, layout, n_bars);
+    return;
   }
 
-  std::stringstream ss;
-  // Chart Header
-  ss << "\t\t" << TextFormat::applyFormat(title, Colors::BLUE, Modifiers::BOLD) << "\n\n";
-  ss << "\t" << TextFormat::applyFormat("Time Stamp: "+timestamp, Colors::BLUE, Modifiers::BOLD) << "\n\n";
+  Profiler::Scope scope(Profiler::RENDER);
+  size_t start_size = out.size();
+  renderHeader(out, symbols);
   //Chart Body
-  sortBars();
+  sortBars(n_bars);
 
-  calcLengths();
+  calcLengths(n_bars, layout.getGeometry().bar_length);
 
-  for (int i = 0; i < n_bars and i < bars.size(); i++) {
-    auto category_color = categories[bars[i]->getCategory()];
-    ss << bars[i]->render(category_color);
+  for (int i = 0; i < n_bars and i < order.size(); i++) {
+    uint32_t bar = order[i];
+    renderBar(out, i, symbols.name(labels[bar]), palette.color(categories[bar]));
   }
   
-  ss << buildXAxis();
-  // Chart Footer
-  ss << TextFormat::applyFormat(x_label, Colors::YELLOW, Modifiers::BOLD) << "\n\n";
-  ss << TextFormat::applyFormat(source, Colors::WHITE, Modifiers::BOLD) << "\n";
+  buildXAxis(out, layout);
+  renderFooter(out, symbols);
   // Color Caption
-  for (const auto &[category_name, category_color] : categories) {
-    ss << TextFormat::applyFormat("   ", category_color, Modifiers::REVERSE) 
-         << TextFormat::applyFormat(": "+category_name, category_color, Modifiers::BOLD)
-         << " ";
+  for (symbol_t category : palette.getLegend()) {
+    color_t category_color = palette.color(category);
+    out.append("   ", category_color, Modifiers::REVERSE);
+    out.append(": ", category_color, Modifiers::BOLD);
+    out.append(palette.name(category), category_color, Modifiers::BOLD);
+    out.appendPlain(" ");
   }
-  ss << '\n';
-  return ss.str();
-}
\ No newline at end of file
+  out.appendPlain("\n");
+  Profiler::add(Profiler::RENDER_BYTES, out.size() - start_size);
+}
+
+/// Appends the chart's title and timestamp.
+void Frame::renderHeader(StyledBuffer &out, const SymbolTable &symbols) const {
+  out.appendPlain("\t\t");
+  out.append(symbols.name(title), Colors::BLUE, Modifiers::BOLD);
+  out.appendPlain("\n\n\t");
+  out.append("Time Stamp: ", Colors::BLUE, Modifiers::BOLD);
+  out.append(symbols.name(timestamp), Colors::BLUE, Modifiers::BOLD);
+  out.appendPlain("\n\n");
+}
+
+/// Appends the x-axis label and the source of the data.
+void Frame::renderFooter(StyledBuffer &out, const SymbolTable &symbols) const {
+  out.append(symbols.name(x_label), Colors::YELLOW, Modifiers::BOLD);
+  out.appendPlain("\n\n");
+  out.append(symbols.name(source), Colors::WHITE, Modifiers::BOLD);
+  out.appendPlain("\n");
+}
@@ -1,87 +1,120 @@
 #pragma once
 
 #include <string>             // std::string
+#include <string_view>        // std::string_view
 #include <vector>             // std::vector
-#include <map>                // std::map
-#include <sstream>            // std::stringstream
-#include <memory>             // std::unique_ptr
 #include <algorithm>          // std::sort, std::max
-#include "libs/text_color.h"  // color_t
+#include <cstdint>            // uint32_t
+#include "symbol_table.h"     // SymbolTable, symbol_t
+#include "layout.h"           // Layout, value_t
+#include "palette.h"          // Palette
+#include "libs/text_color.h"  // color_t, StyledBuffer
 #include "libs/coms.h"        // Logger 
 
 using std::string;
 using std::vector;
 
-constexpr int DEFAULT_BAR_LENGTH = 60;
-constexpr int DEFAULT_AXIS_LENGTH = 60;
-constexpr int DEFAULT_TICKS = 10;
-
-/**
- * @brief A class representing a single bar in the bar chart
- * 
- * Contains the bar's value, display length, label and category information,
- * along with comparison operators for sorting.
- */
-class Bar {
-  int length;      ///< The display length of the bar in characters
-  int value;       ///< The numeric value represented by the bar
-  string label;    ///< The text label for the bar
-  string category; ///< The category this bar belongs to
-  
-  public:
-  Bar() = default;
-  inline auto operator<=>(const Bar &B) const { return this->value <=> B.value; }
-  string render(color_t color) const;
-  void setLength(const int &length) { this->length = length; }
-  void setValue(const int &value) { this->value = value; }
-  void setCategory(const string &category) { this->category = category; }
-  void setLabel(const string &label) { this->label = label; }
-  int getValue() const { return value; }
-  string getCategory() const { return category; }
-  int getLength() const { return length; }
-};
+/// Moves per candidate after which Frame::sortBarsFrom() stops repairing its seed and sorts instead.
+constexpr size_t MAX_SEED_MOVES = 4;
 
 /**
  * @brief A class representing a single frame in a bar chart animation
  * 
  * The Frame class contains all necessary data to render a single frame of a bar chart,
- * including the bars themselves, title, labels, and sizing information.
+ * including the bars themselves, title and labels. How much room it takes on the terminal
+ * is up to the Layout it is rendered with.
+ * 
+ * Bars are stored column by column: the i-th bar is made of the i-th label, category,
+ * value and length. Every string is a symbol_t interned in a SymbolTable shared by all
+ * frames, which is passed to the functions that need the actual text. Categories are
+ * interned in the Palette instead, so their IDs index its colors directly.
  */
 class Frame {
-  std::vector<std::unique_ptr<Bar>> bars;          ///< Collection of bars stored in descending order
-  string title;                                    ///< The title of the chart
-  string x_label;                                  ///< The label for the x-axis
-  string timestamp;                                ///< The timestamp for this frame
-  string source;                                   ///< The data source information
-  int bar_length = DEFAULT_BAR_LENGTH;             ///< Maximum number of characters a bar can occupy
-  int axis_length = DEFAULT_AXIS_LENGTH;           ///< Length of the x-axis in characters
-  int n_ticks = DEFAULT_TICKS;                     ///< Number of tick marks on the x-axis
+  vector<symbol_t> labels;                ///< The text label of each bar
+  vector<symbol_t> categories;            ///< The category each bar belongs to
+  vector<value_t> values;                 ///< The numeric value represented by each bar
+  vector<int> lengths;                    ///< The display length of the visible bars in characters, by rank
+  vector<uint32_t> order;                 ///< Bar indices, the first n_ranked in descending order of value
+  size_t n_ranked = 0;                    ///< Number of bars whose rank is already known
+  symbol_t title = 0;                     ///< The title of the chart
+  symbol_t x_label = 0;                   ///< The label for the x-axis
+  symbol_t timestamp = 0;                 ///< The timestamp for this frame
+  symbol_t source = 0;                    ///< The data source information
+
+  void renderBar(StyledBuffer &out, size_t rank, std::string_view label, color_t color) const;
+  void renderHeader(StyledBuffer &out, const SymbolTable &symbols) const;
+  void renderFooter(StyledBuffer &out, const SymbolTable &symbols) const;
+  /// Whether bar a ranks above bar b: it has a higher value, or the same value and was added first.
+  bool ranksBefore(uint32_t a, uint32_t b) const {
+    return values[a] > values[b] or (values[a] == values[b] and a < b);
+  }
 
   public:
   Frame() = default;
   
+  /// Copies everything but the bars.
   Frame(const Frame& other) : 
   title(other.title),
   x_label(other.x_label),
   timestamp(other.timestamp),
-  source(other.source),
-  bar_length(other.bar_length),
-  axis_length(other.axis_length),
-  n_ticks(other.n_ticks) {}
+  source(other.source) {}
 
-  string render(int n_bars); // Has > 15 categories or none
-  string render(std::map<string,color_t> &categories, int n_bars); // Has between 1 and 15 categories
-  void calcLengths();
-  void sortBars();
-  void addBar(std::unique_ptr<Bar> bar) { bars.push_back(std::move(bar)); }
-  string buildXAxis() const;
-  bool empty() { return bars.empty(); }
+  void render(StyledBuffer &out, const SymbolTable &symbols, Layout &layout, int n_bars); // Has > 15 categories or none
+  void render(StyledBuffer &out, const SymbolTable &symbols, const Palette &palette, Layout &layout, int n_bars); // Has between 1 and 15 categories
+  void calcLengths(size_t n_visible, int bar_length);
+  void sortBars(size_t n_top);
+  bool sortBarsFrom(vector<uint32_t> &seed, size_t n_candidates, size_t n_top);
+  void addBar(symbol_t label, symbol_t category, value_t value) {
+    labels.push_back(label);
+    categories.push_back(category);
+    values.push_back(value);
+    n_ranked = 0;
+  }
+  /// Makes room for n_bars bars, so adding them does not reallocate.
+  void reserveBars(size_t n_bars) {
+    labels.reserve(n_bars);
+    categories.reserve(n_bars);
+    values.reserve(n_bars);
+  }
+  /// Replaces the bars with copies of another frame's bars.
+  void copyBars(const Frame &other) {
+    labels = other.labels;
+    categories = other.categories;
+    values = other.values;
+    n_ranked = 0;
+  }
+  /// Removes every bar, keeping the metadata.
+  void clearBars() {
+    labels.clear();
+    categories.clear();
+    values.clear();
+    n_ranked = 0;
+  }
+  void buildXAxis(StyledBuffer &out, Layout &layout) const;
+  bool empty() const { return values.empty(); }
+  size_t size() const { return values.size(); }
+  const vector<symbol_t> &getLabels() const { return labels; }
+  const vector<symbol_t> &getCategories() const { return categories; }
+  const vector<value_t> &getValues() const { return values; }
+  /// Bar indices, the first ones ranked by the last sort.
+  const vector<uint32_t> &getOrder() const { return order; }
+  symbol_t getTimestamp() const { return timestamp; }
+  symbol_t getTitle() const { return title; }
+  symbol_t getXLabel() const { return x_label; }
+  symbol_t getSource() const { return source; }
 
-  void setMeta(const string title, const string x_label, const string source) {
+  void setMeta(symbol_t title, symbol_t x_label, symbol_t source) {
     this->title = title;
     this->x_label = x_label;
     this->source = source;
   }
 
-  void setTimestamp(const string timestamp) { this->timestamp = timestamp; }
+  void setTimestamp(symbol_t timestamp) { this->timestamp = timestamp; }
+  /// Copies everything but the bars, like the copy constructor, into an existing frame.
+  void copyMeta(const Frame &other) {
+    title = other.title;
+    x_label = other.x_label;
+    timestamp = other.timestamp;
+    source = other.source;
+  }
 };
@@ -0,0 +1,752 @@
+#include <cstdlib>      // EXIT_SUCCESS, EXIT_FAILURE
+#include <cstdio>       // std::remove
+#include <iostream>     // std::cout
+#include <iomanip>      // std::setw, std::setprecision
+#include <queue>        // std::queue
+#include <sstream>      // std::stringstream
+#include <string>       // std::string
+#include <vector>       // std::vector
+#include <memory>       // std::make_shared
+#include <thread>       // std::thread::hardware_concurrency
+#include <fstream>      // std::ofstream
+#include <stdexcept>    // std::logic_error
+#include <string_view>  // std::string_view
+
+#include "bench_utils.h"
+#include "../file_parser.h"
+#include "../screen.h"
+#include "../tween.h"
+#include "../ranker.h"
+#include "../frame_store.h"
+#include "../gap_filler.h"
+
+using std::cout;
+
+bool csv_output = false; ///< Whether results are printed as CSV, for scripts tracking them
+
+/// Prints one measurement as "suite/case  value unit", or as "suite/case,value,unit" in CSV.
+void report(const string &name, double value, const string &unit) {
+  if (csv_output) {
+    cout << name << ',' << std::fixed << std::setprecision(3) << value << ',' << unit << '\n';
+    return;
+  }
+  cout << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(2)
+       << std::setw(12) << value << ' ' << unit << '\n';
+}
+
+/// The tokenizer FileParser used before tokens became views: one heap string per token.
+std::queue<string> legacyTokenizeLine(string &line) {
+  std::queue<string> tokens;
+  string token;
+  bool in_quotes = false;
+  for (char &c : line) {
+    switch(c) {
+      case '"':
+        in_quotes = !in_quotes;
+        break;
+      case ',':
+        if (not in_quotes) {
+          tokens.push(token);
+          token.clear();
+        } else {
+          token += c;
+        }
+        break;
+      default:
+        token += c;
+        break;
+    }
+  }
+  if (not token.empty()) tokens.push(token);
+  return tokens;
+}
+
+/// The scalar tokenizer, one character at a time: what FileParser::tokenizeLine must produce.
+std::vector<string> scalarTokenizeLine(std::string_view line) {
+  std::vector<string> tokens;
+  string token;
+  bool in_quotes = false;
+  for (size_t i = 0; i < line.size(); i++) {
+    if (line[i] == '"') {
+      // Two quotes in a row inside quotes are one quote.
+      if (in_quotes and i + 1 < line.size() and line[i + 1] == '"') {
+        token += '"';
+        i++;
+      } else {
+        in_quotes = !in_quotes;
+      }
+    } else if (line[i] == ',' and not in_quotes) {
+      tokens.push_back(token);
+      token.clear();
+    } else {
+      token += line[i];
+    }
+  }
+  if (not token.empty()) tokens.push_back(token);
+  return tokens;
+}
+
+/**
+ * Checks FileParser::tokenizeLine and countTokens against scalarTokenizeLine at every level of
+ * the FieldScanner, on random lines full of commas and quotes (doubled, unbalanced, across
+ * chunk and window boundaries), both line by line and read from a mapped file as parsing
+ * does. Exits with an error on the first line they disagree on. Then reports the throughput
+ * of the scanner at every level, on the input, a window at a time and line by line.
+ */
+void checkTokenizer(const string &path) {
+  const string lines_path = "bcr_bench_lines.txt";
+  std::mt19937 rng(23);
+  std::vector<string> lines(4000);
+  {
+    std::ofstream out(lines_path, std::ios::binary);
+    out << "Title\nLabel\nSource\n";
+    const char alphabet[] = {'a', 'b', ' ', ',', ',', '"', '"', '\r'};
+    for (auto &line : lines) {
+      size_t length = rng() % 4 == 0 ? rng() % 400 : rng() % 70;
+      for (size_t i = 0; i < length; i++) line += alphabet[rng() % sizeof(alphabet)];
+      out << line << '\n';
+    }
+  }
+
+  FileParser::buffer_t tokens;
+  const FieldScanner::Level best = FieldScanner::best();
+  for (int level = 0; level <= int(best); level++) {
+    FieldScanner::setLevel(FieldScanner::Level(level));
+    auto check = [&] (std::string_view line, const char *how) {
+      std::vector<string> expected = scalarTokenizeLine(line);
+      bool same = tokens.size() == expected.size() and FileParser::countTokens(line) == expected.size();
+      for (size_t i = 0; same and i < tokens.size(); i++) same = tokens[i] == expected[i];
+      if (not same) {
+        std::cerr << "tokenize/" << FieldScanner::name(FieldScanner::Level(level)) << ": " << how
+                  << " tokenizing does not match the scalar tokenizer on [" << line << "]\n";
+        std::remove(lines_path.c_str());
+        exit(EXIT_FAILURE);
+      }
+    };
+
+    FileParser tokenizer(lines_path, nullptr);
+    for (const string &line : lines) {
+      tokenizer.tokenizeLine(line, tokens);
+      check(line, "line by line");
+    }
+
+    auto animation = std::make_shared<AnimationManager>();
+    FileParser parser(lines_path, animation);
+    parser.loadHeader();
+    std::string_view line;
+    while (parser.getline(line)) {
+      parser.tokenizeLine(line, tokens);
+      check(line, "mapped");
+    }
+  }
+  std::remove(lines_path.c_str());
+
+  MappedFile mapping(path);
+  std::string_view text = mapping.view();
+  std::vector<uint32_t> separators;
+  for (int level = 0; level <= int(best); level++) {
+    FieldScanner::setLevel(FieldScanner::Level(level));
+    Timer timer;
+    for (size_t start = 0; start < text.size(); start += FileParser::SCAN_WINDOW) {
+      FieldScanner::findSeparators(text.substr(start, FileParser::SCAN_WINDOW), separators);
+    }
+    double window_time = timer.seconds();
+
+    std::string_view unread = text;
+    timer.reset();
+    while (not unread.empty()) {
+      size_t end = std::min(unread.find('\n'), unread.size());
+      FieldScanner::findSeparators(unread.substr(0, end), separators);
+      unread.remove_prefix(std::min(end + 1, unread.size()));
+    }
+    double line_time = timer.seconds();
+
+    string name = FieldScanner::name(FieldScanner::Level(level));
+    report("tokenize/scan_" + name + "_window", text.size() / 1e6 / window_time, "MB/s");
+    report("tokenize/scan_" + name + "_line", text.size() / 1e6 / line_time, "MB/s");
+  }
+  FieldScanner::setLevel(best);
+}
+
+/// Input throughput of the legacy getline/queue path against FileParser's STREAM, MAPPED and parallel modes.
+void benchParser(const string &path, size_t n_bytes) {
+  const double mb = n_bytes / 1e6;
+  const int reps = 3;
+
+  double best = 1e30;
+  size_t n_tokens = 0;
+  for (int r = 0; r < reps; r++) {
+    Timer timer;
+    std::ifstream file(path);
+    string line;
+    n_tokens = 0;
+    while (std::getline(file, line)) n_tokens += legacyTokenizeLine(line).size();
+    best = std::min(best, timer.seconds());
+  }
+  report("parser/legacy_tokenize", mb / best, "MB/s");
+
+  best = 1e30;
+  FileParser tokenizer(path, nullptr);
+  FileParser::buffer_t tokens;
+  for (int r = 0; r < reps; r++) {
+    Timer timer;
+    MappedFile mapping(path);
+    std::string_view unread = mapping.view();
+    while (not unread.empty()) {
+      size_t end = std::min(unread.find('\n'), unread.size());
+      tokenizer.tokenizeLine(unread.substr(0, end), tokens);
+      unread.remove_prefix(std::min(end + 1, unread.size()));
+    }
+    best = std::min(best, timer.seconds());
+  }
+  report("parser/mapped_tokenize", mb / best, "MB/s");
+
+  for (auto [name, mode] : {std::pair{"parser/stream_load", FileParser::ParseMode::STREAM},
+                            std::pair{"parser/mapped_load", FileParser::ParseMode::MAPPED}}) {
+    best = 1e30;
+    for (int r = 0; r < reps; r++) {
+      auto animation = std::make_shared<AnimationManager>();
+      FileParser parser(path, animation, mode);
+      Timer timer;
+      parser.loadFile();
+      best = std::min(best, timer.seconds());
+    }
+    report(name, mb / best, "MB/s");
+  }
+
+  const unsigned n_jobs = std::max(2u, std::thread::hardware_concurrency());
+  best = 1e30;
+  for (int r = 0; r < reps; r++) {
+    auto animation = std::make_shared<AnimationManager>();
+    FileParser parser(path, animation);
+    parser.setJobs(n_jobs);
+    Timer timer;
+    parser.loadFile();
+    best = std::min(best, timer.seconds());
+  }
+  report("parser/parallel_load_j" + std::to_string(n_jobs), mb / best, "MB/s");
+}
+
+/// Heap bytes of a frame kept as it is: the object and its bar vectors.
+size_t frameBytes(const Frame &frame) {
+  return sizeof(Frame) + (frame.getLabels().capacity() + frame.getCategories().capacity()) * sizeof(symbol_t)
+       + frame.getValues().capacity() * sizeof(value_t) + frame.getOrder().capacity() * sizeof(uint32_t);
+}
+
+/**
+ * Time to load every frame of the file and the memory the frames occupy afterwards, kept as
+ * they are and compressed in a FrameStore (with a keyframe every 64 frames), and the time
+ * to decode a frame of the store, in order (one delta) and at random (from its keyframe).
+ * Every decoded frame is checked against the frame it was made from.
+ */
+void benchStore(const string &path) {
+  const size_t keyframe_interval = 64;
+  auto load = [&] (bool compressed, double &load_time) {
+    auto animation = std::make_shared<AnimationManager>();
+    if (compressed) animation->enableCompression(keyframe_interval);
+    // The parser (and its mapping of the file) is gone before memory is measured.
+    FileParser parser(path, animation);
+    Timer timer;
+    parser.loadFile();
+    load_time = timer.seconds();
+    return animation;
+  };
+
+  double load_time, compressed_load_time;
+  size_t resident_before = residentBytes();
+  auto compressed = load(true, compressed_load_time);
+  size_t compressed_resident = residentBytes() - resident_before;
+  auto animation = load(false, load_time);
+  size_t resident = residentBytes() - resident_before - compressed_resident;
+
+  const size_t n_frames = animation->numberCharts();
+  size_t frames_bytes = 0;
+  for (size_t i = 0; i < n_frames; i++) frames_bytes += frameBytes(animation->frameAt(i));
+  const FrameStore &store = *compressed->getStore();
+
+  auto check = [&] (size_t i, const Frame &decoded) {
+    const Frame &frame = animation->frameAt(i);
+    if (decoded.getLabels() != frame.getLabels() or decoded.getCategories() != frame.getCategories()
+        or decoded.getValues() != frame.getValues() or decoded.getTimestamp() != frame.getTimestamp()) {
+      std::cerr << "store: frame " << i << " is not decoded as it was added\n";
+      exit(EXIT_FAILURE);
+    }
+  };
+  FrameStore::Cursor cursor;
+  for (size_t i = 0; i < n_frames; i++) check(i, store.read(i, cursor));
+  std::mt19937 rng(11);
+  std::vector<size_t> random_order(n_frames);
+  for (auto &i : random_order) i = rng() % n_frames;
+  for (size_t i : random_order) check(i, store.read(i, cursor));
+
+  Timer timer;
+  for (size_t i = 0; i < n_frames; i++) store.read(i, cursor);
+  double sequential_time = timer.seconds();
+  timer.reset();
+  for (size_t i : random_order) store.read(i, cursor);
+  double random_time = timer.seconds();
+
+  report("store/load_time", load_time * 1e3, "ms");
+  report("store/resident", resident / 1e6, "MB");
+  report("store/frames_bytes", frames_bytes / 1e6, "MB");
+  report("store/compressed_load_time", compressed_load_time * 1e3, "ms");
+  report("store/compressed_resident", compressed_resident / 1e6, "MB");
+  report("store/compressed_bytes", store.memoryUsage() / 1e6, "MB");
+  if (n_frames == 0) return;
+  report("store/decode_sequential", sequential_time * 1e9 / n_frames, "ns/frame");
+  report("store/decode_random", random_time * 1e9 / n_frames, "ns/frame");
+}
+
+/// Time to open a compiled dataset, against loading the text, and to decode one of its frames.
+void benchCompiled(const string &path) {
+  const string compiled_path = "bcr_bench_data.bcrb";
+  {
+    auto animation = std::make_shared<AnimationManager>();
+    FileParser parser(path, animation);
+    parser.loadFile();
+    if (not animation->saveCompiled(compiled_path)) return;
+  }
+
+  auto animation = std::make_shared<AnimationManager>();
+  Timer timer;
+  bool opened = animation->openCompiled(compiled_path);
+  double open_time = timer.seconds();
+  if (opened and animation->numberCharts() > 0) {
+    const CompiledDataset &compiled = animation->getCompiled();
+    Frame frame;
+    timer.reset();
+    for (size_t i = 0; i < compiled.size(); i++) compiled.readFrame(i, frame);
+    double decode_time = timer.seconds() / compiled.size();
+    report("compiled/open_time", open_time * 1e3, "ms");
+    report("compiled/decode_time", decode_time * 1e6, "us/frame");
+
+    // Seeking: finding a timestamp in the index and decoding its frame.
+    std::mt19937 rng(3);
+    const int n_seeks = 100'000;
+    size_t checksum = 0;
+    timer.reset();
+    for (int i = 0; i < n_seeks; i++) {
+      std::string_view timestamp = animation->getSymbols().name(compiled.timestampOf(rng() % compiled.size()));
+      size_t found = animation->findTimestamp(timestamp);
+      compiled.readFrame(found, frame);
+      checksum += frame.size();
+    }
+    report("compiled/seek_time", timer.seconds() * 1e6 / n_seeks, "us/seek");
+    if (checksum == 0) cout << "(no bars found while seeking)\n";
+  }
+  std::remove(compiled_path.c_str());
+}
+
+/**
+ * Time spent per frame on each step between the input file and the terminal, so a
+ * regression can be traced to its phase:
+ * - tokenize: splitting the frame's lines into tokens;
+ * - parse: loading the frame (tokenizing included) on a single thread;
+ * - sort, calc_lengths, build_x_axis: the steps of render() that depend on the values;
+ * - build_x_axis_cached: the same, reusing the axis of the previous frame when it prints the same
+ *   tick labels (x_axis_builds is the share of frames whose axis had to be built);
+ * - render: rendering the whole frame once it was ranked;
+ * - write: writing the rendered frame to an output stream (/dev/null, so no terminal is involved).
+ */
+void benchPhases(const string &path) {
+  const int n_bars = 15;
+  auto animation = std::make_shared<AnimationManager>();
+  FileParser parser(path, animation);
+  parser.setJobs(1);
+  Timer timer;
+  parser.loadFile();
+  double parse_time = timer.seconds();
+  const size_t n_frames = animation->numberCharts();
+  if (n_frames == 0) return;
+
+  FileParser tokenizer(path, nullptr);
+  FileParser::buffer_t tokens;
+  MappedFile mapping(path);
+  std::string_view unread = mapping.view();
+  timer.reset();
+  while (not unread.empty()) {
+    size_t end = std::min(unread.find('\n'), unread.size());
+    tokenizer.tokenizeLine(unread.substr(0, end), tokens);
+    unread.remove_prefix(std::min(end + 1, unread.size()));
+  }
+  double tokenize_time = timer.seconds();
+
+  std::vector<Frame*> frames;
+  for (size_t i = 0; i < n_frames; i++) frames.push_back(&animation->frameAt(i));
+  auto time_each = [&] (auto step) {
+    Timer step_timer;
+    for (Frame *frame : frames) step(*frame);
+    return step_timer.seconds();
+  };
+
+  StyledBuffer out;
+  double sort_time = time_each([&] (Frame &frame) { frame.sortBars(n_bars); });
+  Layout layout;
+  double lengths_time = time_each([&] (Frame &frame) { frame.calcLengths(n_bars, layout.getGeometry().bar_length); });
+  double axis_time = time_each([&] (Frame &frame) {
+    Layout uncached;
+    out.clear();
+    frame.buildXAxis(out, uncached);
+  });
+  double cached_axis_time = time_each([&] (Frame &frame) { out.clear(); frame.buildXAxis(out, layout); });
+  size_t axis_builds = layout.axisBuilds();
+
+  std::vector<string> rendered;
+  const SymbolTable &symbols = animation->getSymbols();
+  const Palette &palette = animation->getCategories();
+  double render_time = time_each([&] (Frame &frame) {
+    out.clear();
+    frame.render(out, symbols, palette, layout, n_bars);
+    rendered.emplace_back(out.finish());
+  });
+
+  std::ofstream sink("/dev/null", std::ios::binary);
+  timer.reset();
+  for (const string &frame : rendered) sink << "\033[u\033[J" << frame << std::flush;
+  double write_time = timer.seconds();
+
+  for (auto [name, seconds] : {std::pair{"tokenize", tokenize_time}, std::pair{"parse", parse_time},
+                               std::pair{"sort", sort_time}, std::pair{"calc_lengths", lengths_time},
+                               std::pair{"build_x_axis", axis_time}, std::pair{"build_x_axis_cached", cached_axis_time},
+                               std::pair{"render", render_time},
+                               std::pair{"write", write_time}}) {
+    report("phase/" + string(name), seconds * 1e6 / n_frames, "us/frame");
+  }
+  report("phase/x_axis_builds", 100.0 * axis_builds / n_frames, "%");
+}
+
+/**
+ * Cost of ranking a frame as render() does, for frames of 100, 10k and 1M bars.
+ * "full" sorts every bar (what rendering used to do), "top15" only ranks the bars displayed.
+ */
+void benchSort() {
+  std::mt19937 rng(7);
+  for (size_t n_bars : {100, 10'000, 1'000'000}) {
+    const size_t n_frames = std::max<size_t>(3, 2'000'000 / n_bars);
+    for (auto [name, n_top] : {std::pair{"full", n_bars}, std::pair{"top15", size_t(15)}}) {
+      std::vector<Frame> frames(n_frames);
+      for (auto &frame : frames) {
+        for (size_t i = 0; i < n_bars; i++) frame.addBar(i, 0, rng() % 1'000'000);
+      }
+
+      Timer timer;
+      for (auto &frame : frames) {
+        frame.sortBars(n_top);
+        frame.calcLengths(15, Geometry::DEFAULT_LENGTH);
+      }
+      double per_frame = timer.seconds() / n_frames;
+      report("sort/" + string(name) + "_n" + std::to_string(n_bars), per_frame * 1e6, "us/frame");
+    }
+  }
+}
+
+/**
+ * Cost of ranking consecutive frames from scratch and from the previous frame's ranking, on
+ * the input's frames and on random walks of 10k and 100k bars (values drift a little from
+ * frame to frame, as in real data). "sort_full" sorts every bar, "sort_top15" only ranks the
+ * bars displayed, and "incremental" repairs the previous ranking with a Ranker, which must
+ * rank the bars displayed as "sort_full" does.
+ */
+void benchRank(const string &path) {
+  auto run = [] (const string &name, const std::vector<Frame> &source) {
+    auto copy = [&] () {
+      std::vector<Frame> frames(source.size());
+      for (size_t f = 0; f < source.size(); f++) {
+        for (size_t i = 0; i < source[f].size(); i++) {
+          frames[f].addBar(source[f].getLabels()[i], source[f].getCategories()[i], source[f].getValues()[i]);
+        }
+      }
+      return frames;
+    };
+    std::vector<Frame> full = copy(), top = copy(), incremental = copy();
+    Timer timer;
+    for (auto &frame : full) frame.sortBars(frame.size());
+    double full_time = timer.seconds();
+    timer.reset();
+    for (auto &frame : top) frame.sortBars(15);
+    double top_time = timer.seconds();
+    Ranker ranker;
+    timer.reset();
+    for (auto &frame : incremental) ranker.rank(frame, 15);
+    double incremental_time = timer.seconds();
+
+    for (size_t f = 0; f < source.size(); f++) {
+      size_t n_top = std::min<size_t>(15, source[f].size());
+      if (not std::equal(full[f].getOrder().begin(), full[f].getOrder().begin() + n_top, incremental[f].getOrder().begin())) {
+        std::cerr << "rank/" << name << ": the incremental ranking of frame " << f << " is not the sorted one\n";
+        exit(EXIT_FAILURE);
+      }
+    }
+    for (auto [method, seconds] : {std::pair{"sort_full", full_time}, std::pair{"sort_top15", top_time},
+                                   std::pair{"incremental", incremental_time}}) {
+      report("rank/" + string(method) + "_" + name, seconds * 1e6 / source.size(), "us/frame");
+    }
+  };
+
+  auto animation = std::make_shared<AnimationManager>();
+  FileParser parser(path, animation);
+  parser.loadFile();
+  std::vector<Frame> input(animation->numberCharts());
+  for (size_t f = 0; f < input.size(); f++) {
+    const Frame &frame = animation->frameAt(f);
+    for (size_t i = 0; i < frame.size(); i++) {
+      input[f].addBar(frame.getLabels()[i], frame.getCategories()[i], frame.getValues()[i]);
+    }
+  }
+  if (not input.empty()) run("input", input);
+
+  std::mt19937 rng(13);
+  std::uniform_int_distribution<int> step(-500, 3000);
+  for (size_t n_bars : {10'000, 100'000}) {
+    std::vector<Frame> walk(std::max<size_t>(3, 2'000'000 / n_bars));
+    std::vector<value_t> values(n_bars);
+    for (auto &value : values) value = 1000 + rng() % 100000;
+    for (auto &frame : walk) {
+      for (size_t i = 0; i < n_bars; i++) frame.addBar(i, 0, values[i] += step(rng));
+    }
+    run("walk_n" + std::to_string(n_bars), walk);
+  }
+}
+
+/// How Bar::render formatted a bar before StyledBuffer: one temporary string per span.
+string legacyRenderBar(int length, const string &label, int value, color_t color) {
+  std::stringstream ss;
+  string bar = string(length, ' ');
+  ss   << TextFormat::applyFormat(bar, color, Modifiers::REVERSE)
+       << TextFormat::applyFormat(label, color) << TextFormat::applyFormat(" [", color) 
+       << TextFormat::applyFormat(std::to_string(value), color) << TextFormat::applyFormat("]", color) << "\n";
+  return ss.str();
+}
+
+/// Bytes emitted and time spent per bar by the legacy formatting and by StyledBuffer.
+void benchFormat() {
+  const int n_bars = 1'000'000;
+  std::vector<string> labels;
+  for (int i = 0; i < 100; i++) labels.push_back("Entity " + std::to_string(i));
+  auto color_of = [] (int i) { return Colors::COLORS[i % 7]; };
+
+  size_t n_bytes = 0;
+  Timer timer;
+  for (int i = 0; i < n_bars; i++) {
+    n_bytes += legacyRenderBar(i % 60, labels[i % 100], i, color_of(i)).size();
+  }
+  double elapsed = timer.seconds();
+  report("format/legacy_bytes", double(n_bytes) / n_bars, "B/bar");
+  report("format/legacy_time", elapsed * 1e9 / n_bars, "ns/bar");
+
+  StyledBuffer out;
+  n_bytes = 0;
+  timer.reset();
+  for (int i = 0; i < n_bars; i++) {
+    // A frame's worth of bars per buffer, as rendering does.
+    if (i % 15 == 0) {
+      n_bytes += out.finish().size();
+      out.clear();
+    }
+    out.appendFill(i % 60, ' ', color_of(i), Modifiers::REVERSE);
+    out.append(labels[i % 100], color_of(i));
+    out.append(" [", color_of(i));
+    out.appendNumber(i, color_of(i));
+    out.append("]", color_of(i));
+    out.appendPlain("\n");
+  }
+  n_bytes += out.finish().size();
+  elapsed = timer.seconds();
+  report("format/styled_bytes", double(n_bytes) / n_bars, "B/bar");
+  report("format/styled_time", elapsed * 1e9 / n_bars, "ns/bar");
+}
+
+/// Bytes written per frame when redrawing whole frames and when only writing what changed.
+void benchScreen(const string &path) {
+  for (int n_bars : {5, 15}) {
+    auto animation = std::make_shared<AnimationManager>();
+    FileParser parser(path, animation);
+    parser.loadFile();
+    animation->prerenderAll(n_bars);
+    const FrameCache &frames = animation->getRendered();
+    if (frames.empty()) return;
+
+    size_t full_bytes = 0, diff_bytes = 0;
+    Screen screen;
+    Timer timer;
+    for (size_t i = 0; i < frames.size(); i++) {
+      // Full redraws restore the cursor and clear the screen first ("\033[u\033[J").
+      full_bytes += frames[i].size() + (i > 0 ? 6 : 0);
+      diff_bytes += screen.update(frames[i]).size();
+    }
+    double elapsed = timer.seconds();
+    string suffix = "_b" + std::to_string(n_bars);
+    report("screen/full_bytes" + suffix, double(full_bytes) / frames.size(), "B/frame");
+    report("screen/diff_bytes" + suffix, double(diff_bytes) / frames.size(), "B/frame");
+    report("screen/diff_time" + suffix, elapsed * 1e6 / frames.size(), "us/frame");
+  }
+}
+
+/**
+ * Cost of making and ranking an in-between frame for 1k, 10k and 100k bars, which has to
+ * stay well under the 41 ms a frame lasts at 24 fps. Consecutive frames have the same bars
+ * but for a few that enter and leave the chart.
+ */
+void benchTween() {
+  std::mt19937 rng(11);
+  const int n_steps = 8;
+  for (size_t n_bars : {1'000, 10'000, 100'000}) {
+    const size_t n_frames = std::max<size_t>(3, 1'000'000 / n_bars);
+    std::vector<Frame> frames(n_frames);
+    for (size_t f = 0; f < n_frames; f++) {
+      for (size_t i = 0; i < n_bars; i++) {
+        frames[f].addBar(i + (rng() % 100 == 0 ? n_bars : 0), 0, rng() % 1'000'000);
+      }
+    }
+
+    Tweener tweener;
+    double push_time = 0, tween_time = 0;
+    Timer timer;
+    for (auto &frame : frames) {
+      timer.reset();
+      tweener.push(frame);
+      push_time += timer.seconds();
+      timer.reset();
+      for (int step = 1; step <= n_steps; step++) {
+        Frame &tween = tweener.at(double(step) / (n_steps + 1));
+        tween.sortBars(15);
+        tween.calcLengths(15, Geometry::DEFAULT_LENGTH);
+      }
+      tween_time += timer.seconds();
+    }
+    string suffix = "_n" + std::to_string(n_bars);
+    report("tween/push" + suffix, push_time * 1e6 / n_frames, "us/frame");
+    report("tween/tween" + suffix, tween_time * 1e6 / (n_frames * n_steps), "us/frame");
+  }
+}
+
+/**
+ * Time to fill the entities missing from sparse frames, carried forward and decayed, with
+ * tables of several sizes: each frame only lists a third of the entities, picked at random.
+ */
+void benchFill() {
+  std::mt19937 rng(11);
+  for (size_t n_entities : {1'000, 10'000, 100'000}) {
+    const size_t n_frames = std::max<size_t>(3, 1'000'000 / n_entities);
+    std::vector<std::vector<std::pair<symbol_t, value_t>>> rows(n_frames);
+    for (auto &frame_rows : rows) {
+      for (size_t i = 0; i < n_entities; i++) {
+        if (rng() % 3 == 0) frame_rows.emplace_back(i, rng() % 1'000'000);
+      }
+    }
+
+    for (auto mode : {GapFiller::Mode::CARRY, GapFiller::Mode::DECAY}) {
+      GapFiller filler(mode);
+      Frame frame;
+      double fill_time = 0;
+      Timer timer;
+      for (const auto &frame_rows : rows) {
+        // The same frame is reused, as the tweener does, so filling it only allocates while it grows.
+        frame.clearBars();
+        for (auto [label, value] : frame_rows) frame.addBar(label, 0, value);
+        timer.reset();
+        filler.fill(frame);
+        fill_time += timer.seconds();
+      }
+      string name = mode == GapFiller::Mode::CARRY ? "fill/carry" : "fill/decay";
+      report(name + "_n" + std::to_string(n_entities), fill_time * 1e6 / n_frames, "us/frame");
+    }
+  }
+}
+
+/// Prints the usage of bcr_bench and exits.
+void printUsage() {
+  cout << "Usage: bcr_bench [<options>] [<input_data_file>]\n";
+  cout << "Without an input file, a synthetic dataset is generated (and removed afterwards).\n";
+  cout << "Options:\n";
+  cout << "\t--frames <num> Frames of the synthetic dataset. Default value is 2000.\n";
+  cout << "\t--bars <num> Bars in every frame of the synthetic dataset. Default value is 200.\n";
+  cout << "\t--categories <num> Categories of the synthetic dataset. Default value is 10.\n";
+  cout << "\t--label-length <num> Minimum length of the labels. Default value is 0.\n";
+  cout << "\t--quote-density <fraction> Fraction of quoted labels, in [0,1]. Default value is 0.143.\n";
+  cout << "\t--generate <file> Only write the synthetic dataset to <file>.\n";
+  cout << "\t--csv Print the results as \"name,value,unit\" lines, with a header.\n";
+  exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Micro benchmarks for bcr.
+ * 
+ * Usage: bcr_bench [<options>] [<input_data_file>]
+ * Without an input file a synthetic dataset, shaped by the options, is generated in the
+ * working directory. See printUsage() for the options.
+ */
+int main(int argc, char **argv) {
+  string path = "bcr_bench_data.txt";
+  string generate_path = "";
+  bool generated = true;
+  DatasetShape shape;
+
+  for (int arg_n = 1; arg_n < argc; arg_n++) {
+    string arg = argv[arg_n];
+    if (arg == "--csv") {
+      csv_output = true;
+      continue;
+    }
+    if (arg.rfind("--", 0) != 0) {
+      path = arg;
+      generated = false;
+      continue;
+    }
+    if (arg_n + 1 >= argc) printUsage();
+    string value = argv[++arg_n];
+    try {
+      if (arg == "--frames") shape.n_frames = std::stoi(value);
+      else if (arg == "--bars") shape.n_bars = std::stoi(value);
+      else if (arg == "--categories") shape.n_categories = std::stoi(value);
+      else if (arg == "--label-length") shape.label_length = std::stoi(value);
+      else if (arg == "--quote-density") shape.quote_density = std::stod(value);
+      else if (arg == "--generate") generate_path = value;
+      else printUsage();
+    } catch (std::logic_error&) {
+      printUsage();
+    }
+  }
+  if (shape.n_frames < 1 or shape.n_bars < 1 or shape.n_categories < 1 or shape.label_length < 0
+      or shape.quote_density < 0 or shape.quote_density > 1) {
+    printUsage();
+  }
+
+  if (not generate_path.empty()) {
+    size_t n_bytes = writeDataset(generate_path, shape);
+    cout << "Wrote " << generate_path << " (" << n_bytes / 1e6 << " MB)\n";
+    return EXIT_SUCCESS;
+  }
+
+  size_t n_bytes = 0;
+  if (generated) {
+    n_bytes = writeDataset(path, shape);
+  } else {
+    n_bytes = MappedFile(path).size();
+    if (n_bytes == 0) {
+      std::cerr << "Could not read \"" << path << "\"\n";
+      return EXIT_FAILURE;
+    }
+  }
+  if (csv_output) {
+    cout << "name,value,unit\n";
+    report("input/size", n_bytes / 1e6, "MB");
+  } else {
+    cout << "Input: " << path << " (" << n_bytes / 1e6 << " MB)\n";
+  }
+
+  benchStore(path);
+  checkTokenizer(path);
+  benchParser(path, n_bytes);
+  benchCompiled(path);
+  benchPhases(path);
+  benchSort();
+  benchRank(path);
+  benchFormat();
+  benchScreen(path);
+  benchTween();
+  benchFill();
+
+  if (generated) std::remove(path.c_str());
+  return EXIT_SUCCESS;
+}
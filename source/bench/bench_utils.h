@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>       // std::chrono::steady_clock
+#include <fstream>      // std::ofstream
+#include <string>       // std::string
+#include <random>       // std::mt19937
+#include <vector>       // std::vector
+#include <cmath>        // std::floor
+#include <unistd.h>     // sysconf
+
+/// @brief Measures the wall time elapsed since construction or the last reset().
+class Timer {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  public:
+  void reset() { start = std::chrono::steady_clock::now(); }
+  double seconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+};
+
+/// @brief Returns the resident set size of the process, in bytes.
+inline size_t residentBytes() {
+  std::ifstream statm("/proc/self/statm");
+  size_t total_pages = 0, resident_pages = 0;
+  statm >> total_pages >> resident_pages;
+  return resident_pages * sysconf(_SC_PAGESIZE);
+}
+
+/// @brief Shape of a synthetic dataset.
+struct DatasetShape {
+  int n_frames = 2000;
+  int n_bars = 200;                 ///< Bars in every frame
+  int n_categories = 10;
+  int label_length = 0;             ///< Minimum length of the labels, which are padded up to it
+  double quote_density = 1.0 / 7;   ///< Fraction of the labels that are quoted and contain a comma
+};
+
+/**
+ * @brief Writes a synthetic dataset in the format read by FileParser::loadFile.
+ * 
+ * Every frame lists the same n_bars entities with slowly changing values, which is
+ * what real datasets look like. Quoted labels, which contain a comma, are spread evenly
+ * among the others (with the default density, one label in seven is quoted).
+ * 
+ * @return The number of bytes written
+ */
+inline size_t writeDataset(const std::string &path, const DatasetShape &shape) {
+  std::ofstream out(path);
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> step(-500, 3000);
+
+  out << "Synthetic Bar Chart Race\nValue (units)\nSource: bcr_bench\n\n";
+  std::vector<int> values(shape.n_bars);
+  for (auto &value : values) value = 1000 + rng() % 100000;
+
+  std::vector<std::string> labels(shape.n_bars);
+  for (int b = 0; b < shape.n_bars; b++) {
+    bool quoted = std::floor(b * shape.quote_density) != std::floor((b - 1) * shape.quote_density);
+    std::string label = "Entity " + std::to_string(b) + (quoted ? ", Inc" : "");
+    if (int(label.size()) < shape.label_length) label.append(shape.label_length - label.size(), 'x');
+    labels[b] = quoted ? '"' + label + '"' : label;
+  }
+
+  for (int f = 0; f < shape.n_frames; f++) {
+    out << shape.n_bars << '\n';
+    for (int b = 0; b < shape.n_bars; b++) {
+      values[b] += step(rng);
+      out << 1000 + f << ',' << labels[b] << ",info," << values[b] << ",Category " << b % shape.n_categories << '\n';
+    }
+    out << '\n';
+  }
+  return out.tellp();
+}
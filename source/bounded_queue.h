@@ -0,0 +1,76 @@
+#pragma once
+
+#include <queue>                // std::queue
+#include <mutex>                // std::mutex
+#include <condition_variable>   // std::condition_variable
+#include <algorithm>            // std::max
+
+/**
+ * @brief A bounded, blocking queue shared by one producer and one consumer.
+ * 
+ * The producer blocks while the queue is full, so the number of items held in memory
+ * never exceeds the queue's capacity. Once the producer closes the queue, the consumer
+ * drains what is left and then pop() returns false.
+ * 
+ * @tparam T Type of the items, which only needs to be movable
+ */
+template <typename T>
+class BoundedQueue {
+  std::queue<T> items;    ///< Items waiting to be consumed
+  size_t capacity;        ///< Maximum number of items waiting
+  bool closed = false;    ///< Whether the producer is done
+  std::mutex mutex;
+  std::condition_variable not_empty;
+  std::condition_variable not_full;
+
+  public:
+  explicit BoundedQueue(size_t capacity) : capacity(std::max<size_t>(1, capacity)) {}
+
+  /// Adds an item at the back of the queue, waiting for room if it is full.
+  void push(T item) {
+    std::unique_lock<std::mutex> lock(mutex);
+    not_full.wait(lock, [&] { return items.size() < capacity; });
+    items.push(std::move(item));
+    not_empty.notify_one();
+  }
+
+  /// Removes the item at the front of the queue, waiting for one if it is empty.
+  /// @return false if the queue was closed and nothing is left in it
+  bool pop(T &item) {
+    bool waited;
+    return pop(item, waited);
+  }
+
+  /// Same as pop(item), also telling whether the queue was empty, so the consumer had to wait.
+  bool pop(T &item, bool &waited) {
+    std::unique_lock<std::mutex> lock(mutex);
+    waited = items.empty() and not closed;
+    not_empty.wait(lock, [&] { return closed or not items.empty(); });
+    if (items.empty()) return false;
+
+    item = std::move(items.front());
+    items.pop();
+    not_full.notify_one();
+    return true;
+  }
+
+  /// Tells whether no item is waiting right now.
+  bool empty() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return items.empty();
+  }
+
+  /// Tells whether pop() will never return another item, waiting until it is known.
+  bool drained() {
+    std::unique_lock<std::mutex> lock(mutex);
+    not_empty.wait(lock, [&] { return closed or not items.empty(); });
+    return items.empty();
+  }
+
+  /// Marks the end of the stream and wakes up a waiting consumer.
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    not_empty.notify_all();
+  }
+};
@@ -0,0 +1,205 @@
+#include "compiled_dataset.h"
+
+#include <fstream>  // std::ofstream, std::ifstream
+#include <cstring>  // std::memcmp
+#include <bit>      // std::bit_cast
+#include <array>    // std::array
+#include <algorithm> // std::sort
+#include <sys/stat.h>  // stat, S_ISREG
+#include "libs/binary_io.h"  // writeU32, writeU64, readU32, readU64, decodeU32, decodeU64
+
+/// Size of the fixed part of the file, before the frame index.
+static constexpr size_t HEADER_SIZE = 8 + 4 * 7;
+
+/**
+ * @brief Compiles frames, and the strings and categories they use, into a file
+ * 
+ * @param path Where to write the compiled dataset
+ * @param symbols The strings of the frames, metadata included
+ * @param palette The categories of the frames
+ * @param frames The frames, in order
+ * @return false if the file could not be written
+ */
+bool CompiledDataset::save(const std::string &path, const SymbolTable &symbols, const Palette &palette,
+                           const std::vector<std::unique_ptr<Frame>> &frames) {
+  // Categories are renumbered in the order they first appear, which is the order their
+  // colors were given in, so assigning them in file order when loading gives the same colors.
+  std::vector<uint32_t> category_id;
+  std::vector<symbol_t> categories;
+  for (const auto &frame : frames) {
+    for (symbol_t category : frame->getCategories()) {
+      if (category >= category_id.size()) category_id.resize(category + 1, UINT32_MAX);
+      if (category_id[category] != UINT32_MAX) continue;
+      category_id[category] = categories.size();
+      categories.push_back(category);
+    }
+  }
+
+  // Strings are renumbered in the order a serial load interns them: the metadata, then the
+  // timestamp and labels of each frame, and the strings no frame uses last. Threads parsing
+  // in parallel intern them in any order, and the file must not depend on it.
+  const Frame *first = frames.empty() ? nullptr : frames.front().get();
+  std::vector<uint32_t> symbol_id(symbols.size(), UINT32_MAX);
+  std::vector<symbol_t> strings;
+  strings.reserve(symbols.size());
+  auto number = [&] (symbol_t symbol) {
+    if (symbol_id[symbol] != UINT32_MAX) return;
+    symbol_id[symbol] = strings.size();
+    strings.push_back(symbol);
+  };
+  if (first) {
+    std::array<symbol_t, 3> metadata = {first->getTitle(), first->getXLabel(), first->getSource()};
+    std::sort(metadata.begin(), metadata.end());
+    for (symbol_t symbol : metadata) number(symbol);
+  }
+  for (const auto &frame : frames) {
+    number(frame->getTimestamp());
+    for (symbol_t label : frame->getLabels()) number(label);
+  }
+  for (symbol_t symbol = 0; symbol < symbols.size(); symbol++) number(symbol);
+
+  uint64_t offset = HEADER_SIZE + 8 * frames.size();
+  for (symbol_t symbol : strings) offset += 4 + symbols.name(symbol).size();
+  for (symbol_t category : categories) offset += 4 + palette.name(category).size();
+
+  std::ofstream out(path, std::ios::binary);
+  out.write(MAGIC, sizeof(MAGIC));
+  writeU32(out, VERSION);
+  writeU32(out, symbols.size());
+  writeU32(out, categories.size());
+  writeU32(out, frames.size());
+  writeU32(out, first ? symbol_id[first->getTitle()] : 0);
+  writeU32(out, first ? symbol_id[first->getXLabel()] : 0);
+  writeU32(out, first ? symbol_id[first->getSource()] : 0);
+
+  for (const auto &frame : frames) {
+    writeU64(out, offset);
+    offset += 8 + 16 * frame->size();
+  }
+
+  auto writeString = [&out] (std::string_view text) {
+    writeU32(out, text.size());
+    out.write(text.data(), text.size());
+  };
+  for (symbol_t symbol : strings) writeString(symbols.name(symbol));
+  for (symbol_t category : categories) writeString(palette.name(category));
+
+  for (const auto &frame : frames) {
+    writeU32(out, symbol_id[frame->getTimestamp()]);
+    writeU32(out, frame->size());
+    for (symbol_t label : frame->getLabels()) writeU32(out, symbol_id[label]);
+    for (symbol_t category : frame->getCategories()) writeU32(out, category_id[category]);
+    for (value_t value : frame->getValues()) writeU64(out, std::bit_cast<uint64_t>(value));
+  }
+  return bool(out);
+}
+
+/// Tells whether a file starts like a compiled dataset.
+/// Only regular files are read, since reading a pipe would consume the start of the input.
+bool CompiledDataset::isCompiledFile(const std::string &path) {
+  struct stat status;
+  if (stat(path.c_str(), &status) != 0 or not S_ISREG(status.st_mode)) return false;
+  std::ifstream in(path, std::ios::binary);
+  char magic[sizeof(MAGIC)] = {};
+  in.read(magic, sizeof(magic));
+  return in and std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+/**
+ * @brief Maps a compiled dataset and loads its strings and categories
+ * 
+ * The frame index is checked against the size of the file, so readFrame() does not
+ * need to check anything.
+ * 
+ * @param path The compiled dataset
+ * @param symbols Receives the strings, and must be empty so their IDs are the compiled ones
+ * @param palette Receives the categories, which are given their colors, and must be empty
+ * @return false if the file could not be read or is not a valid compiled dataset
+ */
+bool CompiledDataset::open(const std::string &path, SymbolTable &symbols, Palette &palette) {
+  offsets.clear();
+  // Frames are decoded in any order: interactive seeking and parallel exports jump around.
+  mapping = MappedFile(path, MappedFile::Access::RANDOM);
+  std::string_view data = mapping.view();
+  auto fail = [this] () {
+    mapping = MappedFile();
+    offsets.clear();
+    return false;
+  };
+
+  uint32_t version, n_strings, n_categories, n_frames;
+  if (data.size() < HEADER_SIZE or std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) return fail();
+  data.remove_prefix(sizeof(MAGIC));
+  readU32(data, version);
+  readU32(data, n_strings);
+  readU32(data, n_categories);
+  readU32(data, n_frames);
+  readU32(data, title);
+  readU32(data, x_label);
+  readU32(data, source);
+  if (version != VERSION or title >= n_strings or x_label >= n_strings or source >= n_strings) return fail();
+
+  if (data.size() / 8 < n_frames) return fail();
+  offsets.resize(n_frames);
+  for (uint64_t &offset : offsets) readU64(data, offset);
+
+  auto readString = [&data] (std::string_view &text) {
+    uint32_t text_size;
+    if (not readU32(data, text_size) or data.size() < text_size) return false;
+    text = data.substr(0, text_size);
+    data.remove_prefix(text_size);
+    return true;
+  };
+  std::string_view text;
+  for (uint32_t i = 0; i < n_strings; i++) {
+    if (not readString(text) or symbols.intern(text) != i) return fail();
+  }
+  for (uint32_t i = 0; i < n_categories; i++) {
+    if (not readString(text) or palette.intern(text) != i) return fail();
+    palette.assign(i);
+  }
+
+  // Every frame must fit in the file and only use known strings and categories.
+  const std::string_view file = mapping.view();
+  for (uint64_t offset : offsets) {
+    if (offset > file.size() or file.size() - offset < 8) return fail();
+    const char *bytes = file.data() + offset;
+    uint64_t n_bars = decodeU32(bytes + 4);
+    if ((file.size() - offset - 8) / 16 < n_bars) return fail();
+    if (decodeU32(bytes) >= n_strings) return fail();
+    for (uint64_t i = 0; i < n_bars; i++) {
+      if (decodeU32(bytes + 8 + 4 * i) >= n_strings) return fail();
+      if (decodeU32(bytes + 8 + 4 * (n_bars + i)) >= n_categories) return fail();
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Decodes a frame of the dataset
+ * 
+ * @param i The index of the frame, which must be less than size()
+ * @param frame Receives the metadata and bars of the frame, replacing its own
+ * 
+ * Time Complexity: O(n) where n is the number of bars of the frame
+ */
+void CompiledDataset::readFrame(size_t i, Frame &frame) const {
+  const char *bytes = mapping.view().data() + offsets[i];
+  uint32_t n_bars = decodeU32(bytes + 4);
+  const char *labels = bytes + 8;
+  const char *categories = labels + 4 * n_bars;
+  const char *values = categories + 4 * n_bars;
+
+  frame.clearBars();
+  frame.setMeta(title, x_label, source);
+  frame.setTimestamp(decodeU32(bytes));
+  for (uint32_t bar = 0; bar < n_bars; bar++) {
+    frame.addBar(decodeU32(labels + 4 * bar), decodeU32(categories + 4 * bar),
+                 std::bit_cast<value_t>(decodeU64(values + 8 * bar)));
+  }
+}
+
+/// Returns the timestamp of a frame without decoding its bars.
+symbol_t CompiledDataset::timestampOf(size_t i) const {
+  return decodeU32(mapping.view().data() + offsets[i]);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>               // std::string
+#include <string_view>          // std::string_view
+#include <vector>               // std::vector
+#include <memory>               // std::unique_ptr
+#include <cstdint>              // uint32_t, uint64_t
+#include "barchart.h"           // Frame
+#include "symbol_table.h"       // SymbolTable, symbol_t
+#include "palette.h"            // Palette
+#include "libs/mapped_file.h"   // MappedFile
+
+/**
+ * @brief A dataset compiled into a binary file, which is played without parsing any text.
+ * 
+ * The file holds the strings of the dataset, its categories and the bars of each frame as
+ * flat arrays of IDs and values, with an index of where each frame starts. Opening one
+ * maps it in memory and only interns its strings, so it takes milliseconds however many
+ * frames it has. Frames are then decoded on demand, in any order, by readFrame().
+ * 
+ * String IDs are the ones of the SymbolTable the dataset was compiled from, and categories
+ * are stored in the order they were given colors, so a compiled dataset plays exactly like
+ * its text file.
+ * 
+ * File layout (integers are little endian):
+ *   "BCRBDATA" | u32 version | u32 # of strings | u32 # of categories | u32 # of frames
+ *   | u32 title | u32 x label | u32 source
+ *   | u64 offset of each frame
+ *   | per string: u32 size, size bytes | per category: u32 size, size bytes
+ *   | per frame: u32 timestamp, u32 # of bars n, n u32 labels, n u32 categories, n f64 values
+ */
+class CompiledDataset {
+  static constexpr char MAGIC[8] = {'B','C','R','B','D','A','T','A'};
+  static constexpr uint32_t VERSION = 2;
+
+  MappedFile mapping;                 ///< The compiled file
+  std::vector<uint64_t> offsets;      ///< Where each frame starts in the mapping
+  symbol_t title = 0;                 ///< Metadata of every frame
+  symbol_t x_label = 0;
+  symbol_t source = 0;
+
+  public:
+  static bool save(const std::string &path, const SymbolTable &symbols, const Palette &palette,
+                   const std::vector<std::unique_ptr<Frame>> &frames);
+  static bool isCompiledFile(const std::string &path);
+
+  bool open(const std::string &path, SymbolTable &symbols, Palette &palette);
+  bool isOpen() const { return mapping.isOpen(); }
+  size_t size() const { return offsets.size(); }
+  symbol_t getTitle() const { return title; }
+  symbol_t getXLabel() const { return x_label; }
+  symbol_t getSource() const { return source; }
+  void readFrame(size_t i, Frame &frame) const;
+  symbol_t timestampOf(size_t i) const;
+};
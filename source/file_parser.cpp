@@ -1,52 +1,91 @@
 #include "file_parser.h"
 
+#include <thread>   // std::thread
+#include <atomic>   // std::atomic
+#include <mutex>    // std::mutex, std::lock_guard
+#include <charconv> // std::from_chars
+#include <cmath>    // std::isfinite
+#include <filesystem> // std::filesystem::file_size
+#include "libs/profiler.h" // Profiler
+
+/// Removes the blanks around a number and its plus sign, which std::from_chars does not accept.
+static std::string_view trimNumber(std::string_view num) {
+  size_t first = num.find_first_not_of(" \t\r");
+  if (first == std::string_view::npos) return {};
+  num = num.substr(first, num.find_last_not_of(" \t\r") - first + 1);
+  if (num.size() > 1 and num.front() == '+') num.remove_prefix(1);
+  return num;
+}
+
 /// Helper function to parse an unsigned integer
-uint readUnsigned(string &num, Logger::SourceContext &source_context) {
-  try {
-    return std::stoul(num);
-  } catch (std::invalid_argument &e) {
-    Logger::logError2("Invalid Argument while Parsing Unsigned Integer",source_context);
-  } catch (std::out_of_range &e) {
-    Logger::logError2("Out of Range while Parsing Unsigned Integer",source_context);
+uint FileParser::readUnsigned(std::string_view num) {
+  num = trimNumber(num);
+  uint value = 0;
+  auto [end, error] = std::from_chars(num.data(), num.data() + num.size(), value);
+  if (error == std::errc::result_out_of_range) {
+    fail("Out of Range while Parsing Unsigned Integer");
+  } else if (num.empty() or error != std::errc() or end != num.data() + num.size()) {
+    fail("Invalid Argument while Parsing Unsigned Integer");
   }
-  return 0;
+  return value;
 }
 
-/// Helper function to parse a signed integer
-int readSigned(string &num, Logger::SourceContext &source_context) {
-  try {
-    return std::stoi(num);
-  } catch (std::invalid_argument &e) {
-    Logger::logError2("Invalid Argument while Parsing Signed Integer",source_context);
-  } catch (std::out_of_range &e) {
-    Logger::logError2("Out of Range while Parsing Signed Integer",source_context);
+/// Helper function to parse the value of a bar, an integer or a decimal number
+value_t FileParser::readValue(std::string_view num) {
+  num = trimNumber(num);
+  value_t value = 0;
+  auto [end, error] = std::from_chars(num.data(), num.data() + num.size(), value);
+  if (error == std::errc::result_out_of_range) {
+    fail("Out of Range while Parsing Value");
+  } else if (num.empty() or error != std::errc() or end != num.data() + num.size() or not std::isfinite(value)) {
+    // from_chars also accepts "inf" and "nan", which no chart can show.
+    fail("Invalid Argument while Parsing Value");
   }
-  return 0;
+  return value;
+}
+
+/// @brief Reports an error at the current line, which ends the program.
+/// @note A parser that defers its errors only keeps the first one, for its owner to report.
+void FileParser::fail(const std::string &message) {
+  if (not defer_errors) Logger::logError2(message, source_context);
+  if (not error) error = ParseError{message, source_context};
 }
 
 /// Parses the file and outputs the metadata.
 Metadata FileParser::loadFile() {
-  std::ifstream file(file_path);
+  Metadata metadata = loadHeader();
+  loadFrames();
+  return metadata;
+}
 
-  if (!file.is_open()) {
-    Logger::logError1("Could not open file.");
+/// Opens the file and reads the chart's metadata from its first non-empty lines.
+Metadata FileParser::loadHeader() {
+  if (mode == ParseMode::MAPPED) {
+    mapping = MappedFile(file_path);
+    unread = mapping.view();
+    // Pipes and other special files cannot be mapped, so they are read as a stream.
+    if (!mapping.isOpen()) mode = ParseMode::STREAM;
+  }
+  if (mode == ParseMode::STREAM) {
+    stream.open(file_path);
+    if (!stream.is_open()) {
+      Logger::logError1("Could not open file.");
+    }
   }
 
-  Frame ref_frame; // Reference Frame that holds only metadata
   source_context.file = file_path;
 
   // Reading Header of the file 
   string title, x_label, source;
 
   auto getMeta = [&] () -> string {
-    string meta;
-    while(file and meta.empty()) {
-      getline(file, meta);
+    std::string_view meta;
+    while(meta.empty() and getline(meta)) {
       if (meta.empty()) {
         Logger::logWarning2("Ignoring Empty Line while Looking for the Chart's Metadata",source_context);
       }
     }
-    return meta;
+    return string(meta);
   };
 
   title = getMeta();
@@ -55,99 +94,405 @@ Metadata FileParser::loadFile() {
   //Wish I could just do this instead
   //for (auto &meta : {title, x_label, source}) meta = getMeta();
 
-  ref_frame.setMeta(title, x_label, source);
+  SymbolTable &symbols = animation_manager->getSymbols();
+  ref_frame.setMeta(symbols.intern(title), symbols.intern(x_label), symbols.intern(source));
+
+  return {title, x_label, source};
+}
 
-  //Reading data for each Frame
-  string line;
+/// Reads every frame after the header and hands them to the AnimationManager.
+void FileParser::loadFrames() {
+  Profiler::Scope scope(Profiler::LOAD);
+  if (mode == ParseMode::MAPPED and n_jobs > 1) {
+    readFramesParallel();
+  } else {
+    readFramesSerial();
+  }
+  // In parallel loads the workers read the blocks again, but only the scan is counted.
+  Profiler::add(Profiler::LINES, source_context.line);
+  Profiler::add(Profiler::BYTES_READ, bytes_read);
+}
+
+/// Reads the frames one after the other, as lines come.
+void FileParser::readFramesSerial() {
+  std::string_view line;
   buffer_t tokens;
-  while(getline(file, line)) {
+  while(getline(line)) {
     if (line.empty()) continue;
     
-    auto tokens = tokenizeLine(line);
+    tokenizeLine(line, tokens);
     if (tokens.size() == 1) {
-      uint n_bars = readUnsigned(tokens.front(), source_context);
+      uint n_bars = readUnsigned(tokens.front());
       std::unique_ptr<Frame> frame = std::make_unique<Frame>(ref_frame);
-      readFrame(file, *frame, n_bars);
-      animation_manager->addFrame(std::move(frame));
+      readFrame(*frame, n_bars);
+      emitFrame(std::move(frame));
     } else {
       Logger::logError2("Expected only one Token: the Number of Charts in the new Frame", source_context);
     }
   }
+}
 
-  //Return the metadata
-  return {title, x_label, source};
+/**
+ * @brief Reads the frames of the file, then keeps reading the frames appended to it. Never returns.
+ * 
+ * Only complete frames are read: a block whose last lines were not written yet, or a
+ * line without its line break, is left for the next check. The file is checked every
+ * FOLLOW_INTERVAL, and only the bytes after the last complete frame are read again, so
+ * the cost of a check does not depend on the size of the file.
+ * 
+ * Inputs that are not regular files (e.g. pipes) are already read as they are written,
+ * so they are only read until they end.
+ */
+void FileParser::followFrames() {
+  if (mode != ParseMode::MAPPED) {
+    loadFrames();
+    return;
+  }
+  size_t header_size = mapping.size() - unread.size();
+  uintmax_t offset = header_size + readCompleteFrames(unread);
+  mapping = MappedFile();
+
+  while (true) {
+    std::this_thread::sleep_for(FOLLOW_INTERVAL);
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(file_path, error);
+    if (error or size == offset) continue;
+    if (size < offset) {
+      Logger::logWarning1("\"" + file_path + "\" was truncated. Following it from its new end.\n");
+      offset = size;
+      continue;
+    }
+
+    std::ifstream file(file_path, std::ios::binary);
+    follow_buffer.resize(size - offset);
+    file.seekg(offset);
+    file.read(follow_buffer.data(), follow_buffer.size());
+    follow_buffer.resize(file.gcount());
+    offset += readCompleteFrames(follow_buffer);
+  }
+}
+
+/**
+ * @brief Reads the frames of text whose blocks are complete, and hands them over.
+ * 
+ * Reading stops before the first block that is not complete yet (see isCompleteBlock()).
+ * 
+ * @return The number of bytes of text that were read
+ */
+size_t FileParser::readCompleteFrames(std::string_view text) {
+  // A line without its line break may still be being written.
+  unread = text.substr(0, text.rfind('\n') + 1);
+  scanned = {};
+  const size_t n_bytes = unread.size();
+  std::string_view line;
+  buffer_t tokens;
+  while (true) {
+    std::string_view block = unread;
+    int block_line = source_context.line;
+    if (not getline(line)) break;
+    if (line.empty()) continue;
+
+    tokenizeLine(line, tokens);
+    if (tokens.size() != 1) {
+      Logger::logError2("Expected only one Token: the Number of Charts in the new Frame", source_context);
+    }
+    uint n_bars = readUnsigned(tokens.front());
+    if (not isCompleteBlock(unread, n_bars)) {
+      unread = block;
+      source_context.line = block_line;
+      break;
+    }
+    std::unique_ptr<Frame> frame = std::make_unique<Frame>(ref_frame);
+    readFrame(*frame, n_bars);
+    emitFrame(std::move(frame));
+  }
+  return n_bytes - unread.size();
+}
+
+/**
+ * @brief Whether text starts with all the lines of a block of n_bars bars.
+ * 
+ * Follows the same rules as readFrame: lines with too few tokens are skipped, and a line
+ * with a single token ends the block early (it is the header of the next one).
+ */
+bool FileParser::isCompleteBlock(std::string_view text, uint n_bars) {
+  while (n_bars) {
+    size_t end = text.find('\n');
+    if (end == std::string_view::npos) return false;
+    size_t n_tokens = countTokens(text.substr(0, end));
+    if (n_tokens >= 5) n_bars--;
+    else if (n_tokens == 1) return true;
+    text.remove_prefix(end + 1);
+  }
+  return true;
+}
+
+/**
+ * @brief Splits the unread part of the mapping into blocks, one per frame.
+ * 
+ * The scan follows the same rules as readFrame, but only counts tokens, so finding the
+ * boundaries is much cheaper than parsing the blocks. Malformed header lines are
+ * reported here, everything else is reported when the block itself is parsed.
+ */
+std::vector<FileParser::Block> FileParser::scanBlocks() {
+  std::vector<Block> blocks;
+  std::string_view line;
+  buffer_t tokens;
+  while(getline(line)) {
+    if (line.empty()) continue;
+
+    if (countScannedTokens(line) != 1) {
+      Logger::logError2("Expected only one Token: the Number of Charts in the new Frame", source_context);
+    }
+    tokenizeLine(line, tokens);
+    Block block{readUnsigned(tokens.front()), source_context.line, {}};
+
+    const char *start = unread.data();
+    uint remaining = block.n_bars;
+    while(remaining and getline(line)) {
+      size_t n_tokens = countScannedTokens(line);
+      if (n_tokens >= 5) remaining--;
+      else if (n_tokens == 1) break;
+    }
+    block.text = std::string_view(start, unread.data() - start);
+    blocks.push_back(block);
+  }
+  return blocks;
+}
+
+/**
+ * @brief Parses the frames of a mapped file on n_jobs threads.
+ * 
+ * The blocks found by scanBlocks() are parsed independently into Frames, which are then
+ * handed to the AnimationManager in file order, so the result (category colors included)
+ * is the same as the one of a serial load.
+ *
+ * Workers do not exit on an error, as other threads are still running: the error of the
+ * first block that has one is reported once they all stopped, as a serial load would.
+ */
+void FileParser::readFramesParallel() {
+  std::vector<Block> blocks = scanBlocks();
+  std::vector<std::unique_ptr<Frame>> frames(blocks.size());
+  std::atomic<size_t> next_block = 0;
+  std::atomic<size_t> failed_block = blocks.size(); // Lowest block with an error
+  std::mutex error_mutex;
+  std::optional<ParseError> first_error;
+
+  auto worker = [&] () {
+    // Each worker reads through its own parser so cursors and line numbers are not shared.
+    FileParser block_parser(file_path, animation_manager);
+    block_parser.defer_errors = true;
+    for (size_t i = next_block++; i < failed_block; i = next_block++) {
+      block_parser.unread = blocks[i].text;
+      block_parser.source_context = {file_path, blocks[i].header_line};
+      frames[i] = std::make_unique<Frame>(ref_frame);
+      block_parser.readFrame(*frames[i], blocks[i].n_bars);
+      if (block_parser.error) {
+        std::lock_guard lock(error_mutex);
+        if (i < failed_block) {
+          failed_block = i;
+          first_error = std::move(block_parser.error);
+        }
+        break;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < std::min<size_t>(n_jobs, blocks.size()); i++) threads.emplace_back(worker);
+  worker();
+  for (auto &thread : threads) thread.join();
+  if (first_error) Logger::logError2(first_error->message, first_error->context);
+
+  for (auto &frame : frames) emitFrame(std::move(frame));
 }
 
 /// @brief Reads a certain number of bars from the file and fills a Frame with them.
-/// @param file the file input stream to read from 
 /// @param frame the frame to fill with the bars
 /// @param n_bars the number of bars to read
-void FileParser::readFrame(std::ifstream &file, Frame& frame,int n_bars) {
-  string line;
+void FileParser::readFrame(Frame& frame,int n_bars) {
+  Profiler::Scope scope(Profiler::PARSE);
+  // Frames that get their missing entities filled in have room for them from the start.
+  if (size_t known = animation_manager->knownEntities()) frame.reserveBars(known);
+  std::string_view line;
+  buffer_t tokens;
+  uint64_t n_tokens = 0; // Counted here and reported once, to keep the Profiler off the inner loop
   while(n_bars) {
-    getline(file, line);
-    auto tokens = tokenizeLine(line);
-    bool empty = false;
+    if (!getline(line)) {
+      Logger::logWarning2("Reached the End of the File, Assuming Premature end of the Chart",source_context);
+      break;
+    }
+    tokenizeLine(line, tokens);
+    n_tokens += tokens.size();
 
     if (tokens.size() >= 5) {
-      std::unique_ptr<Bar> bar = std::make_unique<Bar>();
-      string timestamp = readBar(*bar, tokens);
-      frame.setTimestamp(timestamp);
-      frame.addBar(std::move(bar));
+      readBar(frame, tokens);
+      if (error) break;
       n_bars--;
     } else if (tokens.size() == 1) {
       Logger::logWarning2("Only one token on the Line, Assuming Premature end of the Chart",source_context);
-      return;
+      break;
     } else {
       Logger::logWarning2("Ignoring Line with Unexpected Number of Tokens",source_context);
     }
   }
+  Profiler::add(Profiler::FRAMES);
+  Profiler::add(Profiler::TOKENS, n_tokens);
+  Profiler::add(Profiler::BARS, frame.size());
 }
 
-string FileParser::readBar(Bar &bar, buffer_t &tokens) {
-  string timestamp = tokens.front();
-  tokens.pop();
-  bar.setLabel(tokens.front());
-  tokens.pop();
-  //Ignore the info in between the label and the value
-  while(tokens.size() > 2) tokens.pop();
-  bar.setValue(readSigned(tokens.front(), source_context));
-  tokens.pop();
-  bar.setCategory(tokens.front());
-  animation_manager->addCategoryColor(bar.getCategory());
-  tokens.pop();
+/// @brief Adds a bar made from the tokens of a line to the frame, and sets the frame's timestamp.
+/// @note The info between the label and the value is ignored.
+void FileParser::readBar(Frame &frame, const buffer_t &tokens) {
+  SymbolTable &symbols = animation_manager->getSymbols();
+  size_t n_tokens = tokens.size();
+  // Every bar of a frame usually repeats the same timestamp.
+  if (last_timestamp.first.empty() or tokens[0] != last_timestamp.first) {
+    last_timestamp = {string(tokens[0]), symbols.intern(tokens[0])};
+  }
+  frame.setTimestamp(last_timestamp.second);
+  frame.addBar(symbols.intern(tokens[1]),
+               animation_manager->getCategories().intern(tokens[n_tokens-1]),
+               readValue(tokens[n_tokens-2]));
+}
 
-  return timestamp;
+/// @brief Reads the next line of the file, incrementing the line number in the source context.
+/// @param line receives a view of the line, valid until the next call
+/// @return false once the end of the file was reached
+bool FileParser::getline(std::string_view &line) {
+  if (mode == ParseMode::MAPPED) {
+    if (unread.empty()) return false;
+    if (unread.data() < scanned.data() or unread.data() >= scanned.data() + scanned.size()) scanWindow();
+    size_t end = unread.find('\n');
+    if (end == std::string_view::npos) end = unread.size();
+    line = unread.substr(0, end);
+    unread.remove_prefix(std::min(end + 1, unread.size()));
+  } else {
+    if (!std::getline(stream, line_buffer)) return false;
+    line = line_buffer;
+  }
+  bytes_read += line.size() + 1;
+  source_context.line++;
+  return true;
 }
 
-//FIXME: Treat quotes inside quotes. For now it only assumes that quotes are 
-/// Takes a string and returns a queue of tokens.
-FileParser::buffer_t FileParser::tokenizeLine(string &line) {
-  buffer_t tokens;
-  string token;
-  bool in_quotes = false; // Flag to check if we are inside a quoted string.
-  for (char &c : line) {
-    switch(c) {
-      case '"':
-        in_quotes = !in_quotes;
-        break;
-      case ',':
-        if (not in_quotes) {
-          tokens.push(token);
-          token.clear();
-        } else {
-          token += c;
-        }
-        break;
-      default:
-        token += c;
-        break;
+/// @brief Finds the separators of the next SCAN_WINDOW bytes of unread, up to the end of a line.
+void FileParser::scanWindow() {
+  scanned = unread;
+  if (unread.size() > SCAN_WINDOW) {
+    size_t end = unread.find('\n', SCAN_WINDOW - 1);
+    if (end != std::string_view::npos) scanned = unread.substr(0, end + 1);
+  }
+  FieldScanner::findSeparators(scanned, separators);
+  next_separator = 0;
+}
+
+/**
+ * @brief Returns the separators of a line
+ * 
+ * Lines of the scanned window use the separators found for it, others are scanned on their own.
+ * 
+ * @param line The line
+ * @param base Receives what must be subtracted from the separators to get offsets in line
+ * @return The separators, valid until the next call
+ */
+std::span<const uint32_t> FileParser::separatorsOf(std::string_view line, size_t &base) {
+  if (line.data() < scanned.data() or line.data() + line.size() > scanned.data() + scanned.size()) {
+    base = 0;
+    FieldScanner::findSeparators(line, line_separators);
+    return line_separators;
+  }
+  base = line.data() - scanned.data();
+  // Lines are read in order, so the search goes on from the end of the previous one.
+  if (next_separator > 0 and separators[next_separator - 1] >= base) next_separator = 0;
+  size_t first = next_separator;
+  while (first < separators.size() and separators[first] < base) first++;
+  size_t last = first;
+  while (last < separators.size() and separators[last] < base + line.size()) last++;
+  next_separator = last;
+  return std::span<const uint32_t>(separators).subspan(first, last - first);
+}
+
+/// @brief Whether a token (starting outside quotes) is empty once its quotes are removed.
+/// @note Only quotes and at most 2 of them: a third one would be a quote inside quotes.
+bool FileParser::unquotesEmpty(std::string_view field) {
+  return field.size() <= 2 and field.find_first_not_of('"') == std::string_view::npos;
+}
+
+/// @brief Counts the tokens tokenizeLine would produce for a line, without producing them.
+size_t FileParser::countTokens(std::string_view line) {
+  size_t n_tokens = 0;
+  size_t last_start = 0; // Where the token after the last separator starts.
+  bool in_quotes = false;
+  for (size_t i = 0; i < line.size(); i++) {
+    if (line[i] == '"') {
+      in_quotes = !in_quotes;
+    } else if (line[i] == ',' and not in_quotes) {
+      n_tokens++;
+      last_start = i + 1;
     }
   }
+  return n_tokens + (unquotesEmpty(line.substr(last_start)) ? 0 : 1);
+}
 
-  if (not token.empty()) {
-    tokens.push(token);
+/// @brief Counts the tokens of a line like countTokens, from the separators of its window.
+size_t FileParser::countScannedTokens(std::string_view line) {
+  size_t base;
+  std::span<const uint32_t> found = separatorsOf(line, base);
+  size_t last_start = found.empty() ? 0 : found.back() - base + 1;
+  return found.size() + (unquotesEmpty(line.substr(last_start)) ? 0 : 1);
+}
+
+/**
+ * @brief Splits a line on commas that are not inside quotes.
+ * 
+ * Quotes are removed from the tokens, except for two quotes in a row inside quotes, which
+ * stand for one quote (as in RFC 4180: "say ""hi""" is the token say "hi").
+ * 
+ * @param line the line to split
+ * @param tokens receives views of the tokens, with their quotes removed
+ * @note Tokens are views over the line itself. Only a token with quotes in its middle
+ *       (e.g. ab"c,d"e) has to be copied, into unquote_buffer.
+ */
+void FileParser::tokenizeLine(std::string_view line, buffer_t &tokens) {
+  tokens.clear();
+  unquote_buffer.clear();
+
+  auto unquote = [&] (std::string_view field) -> std::string_view {
+    size_t first_quote = field.find('"');
+    if (first_quote == std::string_view::npos) return field;
+    // Common case: the whole token is quoted, so the content is just a narrower view.
+    if (first_quote == 0 and field.size() >= 2 and field.back() == '"' 
+        and field.find('"', 1) == field.size() - 1) {
+      return field.substr(1, field.size() - 2);
+    }
+    // The buffer never outgrows the line, so views into it stay valid for the whole line.
+    if (unquote_buffer.capacity() < line.size()) unquote_buffer.reserve(line.size());
+    size_t start = unquote_buffer.size();
+    bool in_quotes = false;
+    for (size_t i = 0; i < field.size(); i++) {
+      if (field[i] != '"') {
+        unquote_buffer += field[i];
+      } else if (in_quotes and i + 1 < field.size() and field[i + 1] == '"') {
+        unquote_buffer += '"';
+        i++;
+      } else {
+        in_quotes = !in_quotes;
+      }
+    }
+    return std::string_view(unquote_buffer).substr(start);
+  };
+
+  size_t base;
+  size_t token_start = 0;
+  for (uint32_t separator : separatorsOf(line, base)) {
+    size_t end = separator - base;
+    tokens.push_back(unquote(line.substr(token_start, end - token_start)));
+    token_start = end + 1;
   }
 
-  return tokens;
-}
\ No newline at end of file
+  std::string_view last = unquote(line.substr(token_start));
+  if (not last.empty()) {
+    tokens.push_back(last);
+  }
+}
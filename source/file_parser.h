@@ -1,11 +1,18 @@
 #pragma once
 
-#include <fstream>      // std::ifstream
-#include <queue>        // std::queue
-#include <memory>       // std::unique_ptr, std::shared_ptr
-#include "barchart.h"   // Frame, Bar
-#include "animation.h"  // AnimationManager
-#include "libs/coms.h"  // Logger
+#include <fstream>              // std::ifstream
+#include <vector>               // std::vector
+#include <string_view>          // std::string_view
+#include <memory>               // std::unique_ptr, std::shared_ptr
+#include <functional>           // std::function
+#include <chrono>               // std::chrono::milliseconds
+#include <span>                 // std::span
+#include <optional>             // std::optional
+#include "barchart.h"           // Frame
+#include "animation.h"          // AnimationManager
+#include "libs/coms.h"          // Logger
+#include "libs/mapped_file.h"   // MappedFile
+#include "libs/field_scanner.h" // FieldScanner
 
 /// @brief Metadata of the Charts 
 struct Metadata {
@@ -20,24 +27,95 @@ struct Metadata {
  * The FileParser class reads and validates input files containing data for bar chart race animations.
  * It processes the file header, metadata, and frame data, creating the necessary data structures
  * for the animation.
+ * 
+ * Lines can be pulled either from an std::ifstream (STREAM) or from a memory mapping of the
+ * whole file (MAPPED). In both modes tokens are views over the current line, so no string is
+ * allocated per token. In MAPPED mode the frames can also be parsed by several threads.
+ * 
+ * In MAPPED mode the FieldScanner finds where the tokens end for a whole window of lines at
+ * a time, as they are reached, so tokenizing a line only has to cut it at those offsets.
  */
 class FileParser {
+  public:
+  /// @brief How the input file is read.
+  enum class ParseMode { STREAM, MAPPED };
+  typedef std::vector<std::string_view> buffer_t;
+  /// @brief How often a followed file is checked for new frames.
+  static constexpr std::chrono::milliseconds FOLLOW_INTERVAL{200};
+  /// @brief Bytes of a mapping scanned for separators at a time (rounded up to the end of a line).
+  static constexpr size_t SCAN_WINDOW = 64 * 1024;
+  /// @brief Receives each frame read, in file order.
+  using FrameSink = std::function<void(std::unique_ptr<Frame>)>;
+
+  /// @brief The lines of one frame, found by the pre-scan of a mapped file.
+  struct Block {
+    uint n_bars;            ///< Number of bars announced by the block's header line
+    int header_line;        ///< Line number of the header line
+    std::string_view text;  ///< The lines after the header that belong to the frame
+  };
+
+  private:
+  /// @brief An error a worker ran into, reported once the other workers stopped.
+  struct ParseError {
+    string message;
+    Logger::SourceContext context;
+  };
+
   string file_path;                                     ///< Path to the input file
+  ParseMode mode;                                       ///< How the input file is read
+  unsigned n_jobs = 1;                                  ///< Number of threads parsing frames (MAPPED mode)
   Logger::SourceContext source_context;                 ///< Logger source context for the FileParser class
+  Frame ref_frame;                                      ///< Reference Frame that holds only metadata
   std::shared_ptr<AnimationManager> animation_manager;  ///< Pointer to the AnimationManager instance
+  FrameSink frame_sink;                                 ///< Where frames go instead of the AnimationManager, if set
 
-  public:
-  typedef std::queue<string> buffer_t;
+  std::ifstream stream;         ///< Input stream (STREAM mode)
+  string line_buffer;           ///< Storage for the last line read (STREAM mode)
+  MappedFile mapping;           ///< Memory mapping of the input file (MAPPED mode)
+  std::string_view unread;      ///< Part of the mapping not consumed yet (MAPPED mode)
+  string unquote_buffer;        ///< Storage for tokens that had quotes removed from their middle
+  std::pair<string, symbol_t> last_timestamp;  ///< Last timestamp read and its symbol
+  uint64_t bytes_read = 0;      ///< Bytes of the lines read so far, for the Profiler
+  string follow_buffer;         ///< Storage for the bytes appended to a followed file
+  std::string_view scanned;     ///< Lines of the mapping whose separators were found (MAPPED mode)
+  std::vector<uint32_t> separators;      ///< Offsets in scanned of its separators
+  size_t next_separator = 0;             ///< First separator after the last line tokenized
+  std::vector<uint32_t> line_separators; ///< Separators of a line outside scanned
+  bool defer_errors = false;             ///< Whether errors are kept in error instead of ending the program
+  std::optional<ParseError> error;       ///< First error met, if errors are deferred
 
-  FileParser(string f_path, std::shared_ptr<AnimationManager> am) : file_path(f_path), animation_manager(am) {};
+  public:
+  FileParser(string f_path, std::shared_ptr<AnimationManager> am, ParseMode mode = ParseMode::MAPPED) :
+    file_path(f_path), mode(mode), animation_manager(am) {};
+  void setJobs(unsigned jobs) { n_jobs = std::max(1u, jobs); }
+  /// Hands the frames read to sink instead of adding them to the AnimationManager.
+  void setFrameSink(FrameSink sink) { frame_sink = std::move(sink); }
   Metadata loadFile();
-  void readFrame(std::ifstream& file, Frame& frame, int n_bars);
-  string readBar(Bar& bar, buffer_t &tokens);
+  Metadata loadHeader();
+  void loadFrames();
+  std::vector<Block> scanBlocks();
+  void readFramesSerial();
+  void readFramesParallel();
+  void followFrames();
+  size_t readCompleteFrames(std::string_view text);
+  static bool isCompleteBlock(std::string_view text, uint n_bars);
+  void readFrame(Frame& frame, int n_bars);
+  void readBar(Frame& frame, const buffer_t &tokens);
   
-  buffer_t tokenizeLine(string &line);
-  //Wrapper for std::getline that increments the line number in the source context
-  std::istream& getline(std::ifstream &file, string &line) { 
-    source_context.line++;
-    return std::getline(file, line);
-  };
-};
\ No newline at end of file
+  void tokenizeLine(std::string_view line, buffer_t &tokens);
+  static size_t countTokens(std::string_view line);
+  bool getline(std::string_view &line);
+
+  private:
+  uint readUnsigned(std::string_view num);
+  value_t readValue(std::string_view num);
+  void fail(const std::string &message);
+  void scanWindow();
+  std::span<const uint32_t> separatorsOf(std::string_view line, size_t &base);
+  size_t countScannedTokens(std::string_view line);
+  static bool unquotesEmpty(std::string_view field);
+  void emitFrame(std::unique_ptr<Frame> frame) {
+    if (frame_sink) frame_sink(std::move(frame));
+    else animation_manager->addFrame(std::move(frame));
+  }
+};
@@ -0,0 +1,64 @@
+#include "frame_cache.h"
+
+#include <fstream>  // std::ofstream, std::ifstream
+#include <cstring>  // std::memcmp
+#include <sys/stat.h>  // stat, S_ISREG
+#include "libs/binary_io.h"  // writeU32, readU32
+
+/// Adds a rendered frame at the end of the cache.
+void FrameCache::add(std::string frame) {
+  rendered.push_back(std::move(frame));
+  frames.push_back(rendered.back());
+}
+
+/// Writes every frame to a cache file.
+/// @return false if the file could not be written
+bool FrameCache::save(const std::string &path) const {
+  std::ofstream out(path, std::ios::binary);
+  out.write(MAGIC, sizeof(MAGIC));
+  writeU32(out, VERSION);
+  writeU32(out, frames.size());
+  for (std::string_view frame : frames) {
+    writeU32(out, frame.size());
+    out.write(frame.data(), frame.size());
+  }
+  return bool(out);
+}
+
+/// Replaces the contents of the cache with the frames of a cache file.
+/// @return false if the file could not be read or is not a valid cache file
+bool FrameCache::load(const std::string &path) {
+  rendered.clear();
+  frames.clear();
+  mapping = MappedFile(path);
+  std::string_view data = mapping.view();
+
+  uint32_t version, n_frames;
+  if (data.size() < sizeof(MAGIC) or std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) return false;
+  data.remove_prefix(sizeof(MAGIC));
+  if (not readU32(data, version) or version != VERSION) return false;
+  if (not readU32(data, n_frames)) return false;
+
+  frames.reserve(n_frames);
+  for (uint32_t i = 0; i < n_frames; i++) {
+    uint32_t frame_size;
+    if (not readU32(data, frame_size) or data.size() < frame_size) {
+      frames.clear();
+      return false;
+    }
+    frames.push_back(data.substr(0, frame_size));
+    data.remove_prefix(frame_size);
+  }
+  return true;
+}
+
+/// Tells whether a file starts like a cache file.
+/// Only regular files are read, since reading a pipe would consume the start of the input.
+bool FrameCache::isCacheFile(const std::string &path) {
+  struct stat status;
+  if (stat(path.c_str(), &status) != 0 or not S_ISREG(status.st_mode)) return false;
+  std::ifstream in(path, std::ios::binary);
+  char magic[sizeof(MAGIC)] = {};
+  in.read(magic, sizeof(magic));
+  return in and std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
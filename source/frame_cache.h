@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>               // std::string
+#include <string_view>          // std::string_view
+#include <vector>               // std::vector
+#include <deque>                // std::deque
+#include <cstdint>              // uint32_t
+#include "libs/mapped_file.h"   // MappedFile
+
+/**
+ * @brief Frames that were already rendered, ready to be written to the terminal.
+ * 
+ * A cache can be saved to disk and loaded back later, so an animation can be replayed
+ * without parsing or rendering anything. A loaded cache is a memory mapping of the file,
+ * and its frames are views into it.
+ * 
+ * File layout (integers are little endian):
+ *   "BCRCACHE" | u32 version | u32 # of frames | per frame: u32 size, size bytes
+ */
+class FrameCache {
+  static constexpr char MAGIC[8] = {'B','C','R','C','A','C','H','E'};
+  static constexpr uint32_t VERSION = 1;
+
+  std::deque<std::string> rendered;     ///< Frames rendered by this process (never moved once added)
+  MappedFile mapping;                   ///< Cache file the frames were loaded from
+  std::vector<std::string_view> frames; ///< Every frame, pointing into rendered or mapping
+
+  public:
+  FrameCache() = default;
+  FrameCache(const FrameCache&) = delete;
+  FrameCache &operator=(const FrameCache&) = delete;
+
+  void add(std::string frame);
+  size_t size() const { return frames.size(); }
+  bool empty() const { return frames.empty(); }
+  std::string_view operator[](size_t i) const { return frames[i]; }
+
+  bool save(const std::string &path) const;
+  bool load(const std::string &path);
+  static bool isCacheFile(const std::string &path);
+};
@@ -0,0 +1,104 @@
+#include "frame_export.h"
+
+#include <filesystem>   // std::filesystem
+#include <algorithm>    // std::count, std::max
+#include <cstdio>       // std::snprintf
+
+namespace fs = std::filesystem;
+
+/// Chooses the format from the path, see the class description.
+FrameExporter::FrameExporter(std::string f_path, double fps) : path(std::move(f_path)), fps(fps) {
+  std::error_code error;
+  if (not path.empty() and (path.back() == '/' or fs::is_directory(path, error))) format = Format::FILES;
+  else if (path.size() > 5 and path.compare(path.size() - 5, 5, ".cast") == 0) format = Format::ASCIICAST;
+  else format = Format::ANSI;
+}
+
+/// Creates the output file, or the output directory for one file per frame.
+/// @return false if it could not be created
+bool FrameExporter::open() {
+  if (format == Format::FILES) {
+    std::error_code error;
+    fs::create_directories(path, error);
+    return fs::is_directory(path, error);
+  }
+  out.open(path, std::ios::binary);
+  if (not out.is_open()) return false;
+  // Same as playing the animation: the frames are drawn from the saved cursor position.
+  if (format == Format::ANSI) out << "\033[s";
+  return true;
+}
+
+/// Writes the next frame.
+void FrameExporter::write(std::string_view frame) {
+  switch (format) {
+    case Format::ANSI:
+      if (n_written > 0) out << "\033[u\033[J";
+      out << frame;
+      break;
+    case Format::ASCIICAST:
+      writeCastEvent(frame);
+      break;
+    case Format::FILES: {
+      char name[32];
+      std::snprintf(name, sizeof(name), "frame_%06zu.ans", n_written + 1);
+      std::ofstream file(fs::path(path) / name, std::ios::binary);
+      file << frame;
+      failed = failed or not file;
+      break;
+    }
+  }
+  n_written++;
+}
+
+/**
+ * @brief Writes a frame as an asciicast output event, preceded by the header for the first one
+ * 
+ * The terminal size in the header is taken from the first frame, with some room to spare.
+ * Each frame clears the screen and is drawn from its top left corner.
+ */
+void FrameExporter::writeCastEvent(std::string_view frame) {
+  if (n_written == 0) {
+    size_t height = std::count(frame.begin(), frame.end(), '\n') + 2;
+    size_t width = 80, line_width = 0;
+    for (char c : frame) {
+      // Escape sequences are counted too, so the width errs on the large side.
+      line_width = c == '\n' ? 0 : line_width + 1;
+      width = std::max(width, line_width);
+    }
+    out << "{\"version\": 2, \"width\": " << std::min<size_t>(width, 200) << ", \"height\": " << height << "}\n";
+  }
+
+  char time[32];
+  std::snprintf(time, sizeof(time), "%.6f", n_written / fps);
+  out << '[' << time << ", \"o\", \"\\u001b[H\\u001b[J";
+  // JSON string escaping. Line breaks also need a carriage return, as the terminal is raw.
+  for (char c : frame) {
+    switch (c) {
+      case '"': out << "\\\""; break;
+      case '\\': out << "\\\\"; break;
+      case '\n': out << "\\r\\n"; break;
+      case '\t': out << "\\t"; break;
+      case '\33': out << "\\u001b"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          out << escaped;
+        } else {
+          out << c;
+        }
+    }
+  }
+  out << "\"]\n";
+}
+
+/// Finishes writing the frames.
+/// @return false if any of them could not be written
+bool FrameExporter::close() {
+  if (out.is_open()) {
+    out.close();
+    failed = failed or out.fail();
+  }
+  return not failed;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>       // std::string
+#include <string_view>  // std::string_view
+#include <fstream>      // std::ofstream
+
+/**
+ * @brief Writes rendered frames to files instead of the terminal.
+ * 
+ * The format depends on the path given:
+ * - "<name>.cast": an asciicast v2 recording, which asciinema plays at the given framerate;
+ * - "<directory>/" (or an existing directory): one file per frame, frame_000001.ans and so on;
+ * - anything else: an ANSI log, the exact bytes a full redraw playback writes to the terminal.
+ * 
+ * Frames must be written in order.
+ */
+class FrameExporter {
+  public:
+  enum class Format { ANSI, ASCIICAST, FILES };
+
+  private:
+  std::string path;       ///< Where the frames go
+  Format format;          ///< How the frames are written
+  double fps;             ///< Framerate of the asciicast recording
+  std::ofstream out;      ///< The output file (not used for one file per frame)
+  size_t n_written = 0;   ///< Number of frames written so far
+  bool failed = false;    ///< Whether a write failed
+
+  void writeCastEvent(std::string_view frame);
+
+  public:
+  FrameExporter(std::string path, double fps);
+
+  bool open();
+  void write(std::string_view frame);
+  bool close();
+  Format getFormat() const { return format; }
+  size_t size() const { return n_written; }
+};
@@ -0,0 +1,131 @@
+#include "frame_merger.h"
+
+#include <thread>   // std::thread
+#include <queue>    // std::priority_queue
+
+/**
+ * @brief Compares two strings in natural order: runs of digits are compared by their value.
+ * 
+ * So "2020-9" < "2020-10" and "Week 9" < "Week 10". Leading zeros are ignored, and any
+ * other character is compared by its code.
+ */
+bool naturalLess(std::string_view a, std::string_view b) {
+  auto isDigit = [] (char c) { return c >= '0' and c <= '9'; };
+  size_t i = 0, j = 0;
+  while (i < a.size() and j < b.size()) {
+    if (isDigit(a[i]) and isDigit(b[j])) {
+      while (i < a.size() and a[i] == '0') i++;
+      while (j < b.size() and b[j] == '0') j++;
+      size_t a_end = i, b_end = j;
+      while (a_end < a.size() and isDigit(a[a_end])) a_end++;
+      while (b_end < b.size() and isDigit(b[b_end])) b_end++;
+      // Without leading zeros, the longer number is the bigger one.
+      if (a_end - i != b_end - j) return a_end - i < b_end - j;
+      int order = a.substr(i, a_end - i).compare(b.substr(j, b_end - j));
+      if (order != 0) return order < 0;
+      i = a_end;
+      j = b_end;
+    } else {
+      if (a[i] != b[j]) return static_cast<unsigned char>(a[i]) < static_cast<unsigned char>(b[j]);
+      i++;
+      j++;
+    }
+  }
+  return a.size() - i < b.size() - j;
+}
+
+/// Parses every file and merges their frames.
+Metadata FrameMerger::loadFile() {
+  Metadata metadata = loadHeader();
+  loadFrames();
+  return metadata;
+}
+
+/**
+ * @brief Opens every file and reads its header.
+ * 
+ * The merged frames get the metadata of the first file. Files with different metadata
+ * are still merged, with a warning.
+ */
+Metadata FrameMerger::loadHeader() {
+  Metadata metadata;
+  for (const string &path : file_paths) {
+    Shard &shard = shards.emplace_back();
+    shard.parser = std::make_unique<FileParser>(path, animation_manager);
+    Metadata shard_metadata = shard.parser->loadHeader();
+    if (shards.size() == 1) {
+      metadata = shard_metadata;
+    } else if (shard_metadata.main_title != metadata.main_title or shard_metadata.x_label != metadata.x_label
+               or shard_metadata.source != metadata.source) {
+      Logger::logWarning1("The header of \"" + path + "\" is not the same as the one of \"" + file_paths.front()
+                          + "\". Using the first one.\n");
+    }
+  }
+
+  SymbolTable &symbols = animation_manager->getSymbols();
+  ref_frame.setMeta(symbols.intern(metadata.main_title), symbols.intern(metadata.x_label), symbols.intern(metadata.source));
+  return metadata;
+}
+
+/**
+ * @brief Parses the frames of every shard on its own thread, and merges them in timestamp order.
+ * 
+ * The shards are merged with a heap of the ones that have a frame at their head, ordered
+ * by the timestamp of that frame and then by the shard's position.
+ */
+void FrameMerger::loadFrames() {
+  std::vector<std::thread> readers;
+  for (Shard &shard : shards) {
+    shard.frames = std::make_unique<FrameQueue>(SHARD_DEPTH);
+    shard.parser->setFrameSink([queue = shard.frames.get()] (std::unique_ptr<Frame> frame) {
+      queue->push(std::move(frame));
+    });
+    readers.emplace_back([&shard] () {
+      shard.parser->loadFrames();
+      shard.frames->close();
+    });
+  }
+
+  const SymbolTable &symbols = animation_manager->getSymbols();
+  // Whether shard a's head comes after shard b's, as the heap keeps the "largest" on top.
+  auto after = [&] (size_t a, size_t b) {
+    symbol_t a_timestamp = shards[a].head->getTimestamp(), b_timestamp = shards[b].head->getTimestamp();
+    if (a_timestamp != b_timestamp) {
+      std::string_view a_name = symbols.name(a_timestamp), b_name = symbols.name(b_timestamp);
+      if (naturalLess(b_name, a_name)) return true;
+      if (naturalLess(a_name, b_name)) return false;
+    }
+    return a > b;
+  };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(after)> heap(after);
+  for (size_t i = 0; i < shards.size(); i++) {
+    if (shards[i].frames->pop(shards[i].head)) heap.push(i);
+  }
+
+  std::vector<size_t> merged_shards;
+  while (not heap.empty()) {
+    merged_shards.assign(1, heap.top());
+    heap.pop();
+    symbol_t timestamp = shards[merged_shards.front()].head->getTimestamp();
+    while (not heap.empty() and shards[heap.top()].head->getTimestamp() == timestamp) {
+      merged_shards.push_back(heap.top());
+      heap.pop();
+    }
+
+    // The first frame receives the bars of the others.
+    std::unique_ptr<Frame> merged = std::move(shards[merged_shards.front()].head);
+    merged->setMeta(ref_frame.getTitle(), ref_frame.getXLabel(), ref_frame.getSource());
+    for (size_t k = 1; k < merged_shards.size(); k++) {
+      const Frame &other = *shards[merged_shards[k]].head;
+      for (size_t bar = 0; bar < other.size(); bar++) {
+        merged->addBar(other.getLabels()[bar], other.getCategories()[bar], other.getValues()[bar]);
+      }
+    }
+    for (size_t i : merged_shards) {
+      if (shards[i].frames->pop(shards[i].head)) heap.push(i);
+    }
+    animation_manager->addFrame(std::move(merged));
+  }
+
+  for (auto &reader : readers) reader.join();
+}
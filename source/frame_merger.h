@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>             // std::unique_ptr, std::shared_ptr
+#include <string>             // std::string
+#include <string_view>        // std::string_view
+#include <vector>             // std::vector
+#include "barchart.h"         // Frame
+#include "animation.h"        // AnimationManager, FrameQueue
+#include "file_parser.h"      // FileParser, Metadata
+
+bool naturalLess(std::string_view a, std::string_view b);
+
+/**
+ * @brief Merges the frames of several input files (shards) into a single race.
+ * 
+ * Each shard holds some of the bars of the same timestamps, e.g. one file per region.
+ * The shards are parsed concurrently, each by its own thread into a small FrameQueue,
+ * while the thread calling loadFrames() merges the frames at their heads: those with the
+ * smallest timestamp become a single Frame, with their bars in the order the files were
+ * given, which is handed to the AnimationManager. Timestamps are compared in natural
+ * order (see naturalLess()), so "9" comes before "10".
+ * 
+ * At most SHARD_DEPTH frames of each shard are held by the merge, however long the shards are.
+ * 
+ * @note Every shard must list its timestamps in ascending order. A shard without some
+ *       timestamp just adds no bars to it.
+ */
+class FrameMerger {
+  static constexpr size_t SHARD_DEPTH = 4;  ///< Frames parsed ahead by each shard
+
+  /// @brief An input file and the frames read from it that were not merged yet.
+  struct Shard {
+    std::unique_ptr<FileParser> parser;
+    std::unique_ptr<FrameQueue> frames;   ///< Frames parsed but not merged yet
+    std::unique_ptr<Frame> head;          ///< Next frame to merge
+  };
+
+  std::vector<string> file_paths;                       ///< Paths to the input files
+  std::shared_ptr<AnimationManager> animation_manager;  ///< Pointer to the AnimationManager instance
+  std::vector<Shard> shards;                            ///< One for each input file
+  Frame ref_frame;                                      ///< Reference Frame that holds only metadata
+
+  public:
+  FrameMerger(std::vector<string> f_paths, std::shared_ptr<AnimationManager> am) :
+    file_paths(std::move(f_paths)), animation_manager(am) {};
+  /// Each shard is parsed by a single thread of its own, whatever the number of jobs.
+  void setJobs(unsigned) {}
+  Metadata loadFile();
+  Metadata loadHeader();
+  void loadFrames();
+};
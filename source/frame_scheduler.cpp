@@ -0,0 +1,71 @@
+#include "frame_scheduler.h"
+
+#include <thread>     // std::this_thread::sleep_until
+#include <algorithm>  // std::sort
+#include <iomanip>    // std::setprecision
+#include "libs/profiler.h" // Profiler
+
+/// Tells whether the current frame is so late that the next one is already due.
+bool FrameScheduler::late() const {
+  return started and clock::now() >= deadline(slot + 1);
+}
+
+/// Skips the current frame, keeping the deadlines of the following ones.
+void FrameScheduler::drop() {
+  slot++;
+  n_dropped++;
+  Profiler::add(Profiler::DROPPED_FRAMES);
+}
+
+/// Marks the beginning of work on the current frame. The first call starts the clock.
+void FrameScheduler::startFrame() {
+  frame_start = clock::now();
+  if (not started) {
+    start = frame_start;
+    started = true;
+  }
+  render_end = write_end = frame_start;
+}
+
+/// Moves every deadline so the current frame is due now, after waiting for it to exist.
+void FrameScheduler::resume() {
+  if (started) start = clock::now() - slot * period;
+}
+
+/// Sleeps until the next frame is due and records how the current one went.
+void FrameScheduler::waitForNextFrame() {
+  slot++;
+  std::this_thread::sleep_until(deadline(slot));
+  end = clock::now();
+  timings.push_back({render_end - frame_start, write_end - render_end, end - write_end});
+}
+
+/**
+ * @brief Prints the achieved framerate, the median and 99th percentile frame times
+ * and the number of dropped frames
+ * 
+ * A frame time is the time between the beginning of a frame and the end of its sleep.
+ */
+void FrameScheduler::printSummary(std::ostream &out) const {
+  if (timings.empty()) return;
+
+  auto ms = [] (clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+  std::vector<double> frame_times;
+  frame_times.reserve(timings.size());
+  double render = 0, write = 0;
+  for (const auto &timing : timings) {
+    frame_times.push_back(ms(timing.render + timing.write + timing.sleep));
+    render += ms(timing.render);
+    write += ms(timing.write);
+  }
+  std::sort(frame_times.begin(), frame_times.end());
+  auto percentile = [&] (double p) { return frame_times[size_t(p * (frame_times.size() - 1))]; };
+
+  double elapsed = std::chrono::duration<double>(end - start).count();
+  out << std::fixed << std::setprecision(2)
+      << ">>> Played " << timings.size() << " charts in " << elapsed << " s: "
+      << timings.size() / elapsed << " fps (target " << std::chrono::seconds(1) / period << " fps)\n"
+      << ">>> Frame time: p50 " << percentile(0.5) << " ms, p99 " << percentile(0.99) << " ms"
+      << " (avg render " << render / timings.size() << " ms, avg write " << write / timings.size() << " ms)\n"
+      << ">>> Dropped charts: " << n_dropped << '\n';
+}
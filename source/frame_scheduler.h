@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>     // std::chrono::steady_clock
+#include <vector>     // std::vector
+#include <ostream>    // std::ostream
+
+/**
+ * @brief Paces the animation on absolute deadlines and measures how each frame went.
+ * 
+ * Frame i is due at start + i * period, where start is the moment the first frame began.
+ * Sleeping until the next deadline (instead of for a whole period) means time spent
+ * rendering and writing is not added to the period, so the animation does not drift.
+ * When a frame is so late that the next one is already due, it should be dropped.
+ * 
+ * Usage, for every frame:
+ *   if (scheduler.late()) scheduler.drop();
+ *   else { startFrame(); render; endRender(); write; endWrite(); waitForNextFrame(); }
+ */
+class FrameScheduler {
+  public:
+  using clock = std::chrono::steady_clock;
+
+  /// @brief Time spent on each step of a displayed frame.
+  struct FrameTiming {
+    clock::duration render;
+    clock::duration write;
+    clock::duration sleep;
+  };
+
+  private:
+  clock::duration period;             ///< Time between two consecutive frames
+  clock::time_point start;            ///< When the first frame began
+  clock::time_point frame_start;      ///< When the current frame began
+  clock::time_point render_end;       ///< When the current frame was rendered
+  clock::time_point write_end;        ///< When the current frame was written
+  clock::time_point end;              ///< When the last frame ended
+  bool started = false;               ///< Whether the first frame began
+  size_t slot = 0;                    ///< Index of the current frame, dropped ones included
+  size_t n_dropped = 0;               ///< Number of frames dropped
+  std::vector<FrameTiming> timings;   ///< Timing of every frame displayed
+
+  clock::time_point deadline(size_t frame) const { return start + frame * period; }
+
+  public:
+  explicit FrameScheduler(int fps) : period(std::chrono::duration_cast<clock::duration>(std::chrono::seconds(1)) / fps) {}
+
+  bool late() const;
+  void drop();
+  void startFrame();
+  void endRender() { render_end = clock::now(); }
+  void endWrite() { write_end = clock::now(); }
+  void waitForNextFrame();
+  void resume();
+  void printSummary(std::ostream &out) const;
+};
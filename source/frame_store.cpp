@@ -0,0 +1,176 @@
+#include "frame_store.h"
+
+#include <cmath>    // std::trunc, std::abs, std::signbit
+#include <bit>      // std::bit_cast
+#include "libs/binary_io.h"  // appendVarint, decodeVarint, zigzag, unzigzag, decodeU64
+
+/// Integers up to this magnitude are exact in a value_t, and so are their differences in an int64_t.
+static constexpr value_t MAX_EXACT = 9007199254740992.0; // 2^53
+
+/// Whether a value is an integer that survives a round trip through an int64_t (-0 does not).
+static bool isExactInteger(value_t value) {
+  return value == std::trunc(value) and std::abs(value) <= MAX_EXACT and not (value == 0 and std::signbit(value));
+}
+
+/**
+ * @brief Finds the bar of the last frame added with a label
+ * 
+ * Frames usually list their bars in the same order, so the same index is tried first.
+ * The other bars are only indexed by label the first time a bar is not found there.
+ * 
+ * @param label The label of the bar
+ * @param i The index of the bar in the frame being added
+ * @return The index of the bar in the last frame, or NO_BAR if it had none with that label
+ */
+uint32_t FrameStore::findLast(symbol_t label, size_t i) {
+  if (i < last_labels.size() and last_labels[i] == label) return i;
+  if (not last_indexed) {
+    for (uint32_t bar = 0; bar < last_labels.size(); bar++) {
+      if (last_labels[bar] >= last_bar_of.size()) last_bar_of.resize(last_labels[bar] + 1, NO_BAR);
+      last_bar_of[last_labels[bar]] = bar;
+    }
+    last_indexed = true;
+  }
+  return label < last_bar_of.size() ? last_bar_of[label] : NO_BAR;
+}
+
+/**
+ * @brief Encodes a frame and appends it to the store
+ * 
+ * Time Complexity: O(n) where n is the number of bars of the frame
+ */
+void FrameStore::add(const Frame &frame) {
+  auto unindex = [this] {
+    if (not last_indexed) return;
+    for (symbol_t label : last_labels) last_bar_of[label] = NO_BAR;
+    last_indexed = false;
+  };
+  if (locations.size() % keyframe_interval == 0) {
+    // Keyframes are encoded against an empty frame.
+    unindex();
+    last_labels.clear();
+    last_categories.clear();
+    last_values.clear();
+  }
+
+  record.clear();
+  for (symbol_t symbol : {frame.getTimestamp(), frame.getTitle(), frame.getXLabel(), frame.getSource()}) {
+    appendVarint(record, symbol);
+  }
+  const vector<symbol_t> &labels = frame.getLabels();
+  const vector<symbol_t> &categories = frame.getCategories();
+  const vector<value_t> &values = frame.getValues();
+  appendVarint(record, labels.size());
+
+  for (size_t i = 0; i < labels.size(); i++) {
+    uint32_t last = findLast(labels[i], i);
+    value_t previous = 0;
+    if (last != NO_BAR and last_categories[last] == categories[i]) {
+      appendVarint(record, 1 + zigzag(int64_t(last) - int64_t(i)));
+      previous = last_values[last];
+    } else {
+      appendVarint(record, 0);
+      appendVarint(record, labels[i]);
+      appendVarint(record, categories[i]);
+    }
+
+    if (isExactInteger(values[i]) and isExactInteger(previous)) {
+      appendVarint(record, zigzag(int64_t(values[i]) - int64_t(previous)) << 1);
+    } else {
+      appendVarint(record, 1);
+      uint64_t bits = std::bit_cast<uint64_t>(values[i]);
+      for (int byte = 0; byte < 8; byte++) record.push_back(uint8_t(bits >> (8 * byte)));
+    }
+  }
+
+  // Blocks are only appended to within their capacity, so what they hold never moves.
+  if (blocks.empty() or blocks.back().capacity() - blocks.back().size() < record.size()) {
+    blocks.emplace_back().reserve(std::max(BLOCK_SIZE, record.size()));
+  }
+  std::vector<uint8_t> &block = blocks.back();
+  locations.push_back({uint32_t(blocks.size() - 1), uint32_t(block.size())});
+  block.insert(block.end(), record.begin(), record.end());
+
+  unindex();
+  last_labels = labels;
+  last_categories = categories;
+  last_values = values;
+}
+
+/// Decodes the record at bytes into the cursor's frame, which must hold the frame before it.
+void FrameStore::decodeNext(const uint8_t *bytes, Cursor &cursor) const {
+  symbol_t timestamp = decodeVarint(bytes);
+  symbol_t title = decodeVarint(bytes);
+  symbol_t x_label = decodeVarint(bytes);
+  symbol_t source = decodeVarint(bytes);
+  size_t n_bars = decodeVarint(bytes);
+
+  const vector<symbol_t> &last_labels = cursor.frame.getLabels();
+  const vector<symbol_t> &last_categories = cursor.frame.getCategories();
+  const vector<value_t> &last_values = cursor.frame.getValues();
+  cursor.labels.resize(n_bars);
+  cursor.categories.resize(n_bars);
+  cursor.values.resize(n_bars);
+
+  for (size_t i = 0; i < n_bars; i++) {
+    uint64_t tag = decodeVarint(bytes);
+    value_t previous = 0;
+    if (tag == 0) {
+      cursor.labels[i] = decodeVarint(bytes);
+      cursor.categories[i] = decodeVarint(bytes);
+    } else {
+      size_t last = i + unzigzag(tag - 1);
+      cursor.labels[i] = last_labels[last];
+      cursor.categories[i] = last_categories[last];
+      previous = last_values[last];
+    }
+
+    uint64_t value = decodeVarint(bytes);
+    if (value & 1) {
+      cursor.values[i] = std::bit_cast<value_t>(decodeU64(reinterpret_cast<const char*>(bytes)));
+      bytes += 8;
+    } else {
+      // Integer arithmetic, so the value is exactly the one that was encoded.
+      cursor.values[i] = value_t(int64_t(previous) + unzigzag(value >> 1));
+    }
+  }
+
+  Frame &frame = cursor.frame;
+  frame.clearBars();
+  frame.setMeta(title, x_label, source);
+  frame.setTimestamp(timestamp);
+  for (size_t i = 0; i < n_bars; i++) frame.addBar(cursor.labels[i], cursor.categories[i], cursor.values[i]);
+}
+
+/**
+ * @brief Decodes a frame
+ * 
+ * Decoding resumes from the cursor's last frame if it is the same one or an earlier one
+ * after the same keyframe, and starts from the keyframe otherwise.
+ * 
+ * @param i The index of the frame
+ * @param cursor Holds the frame decoded, and where decoding can resume from
+ * @return The frame, which belongs to the cursor and is valid until it decodes another one
+ * 
+ * Time Complexity: O(n * d) where n is the number of bars and d the number of deltas
+ *                  decoded: 1 when frames are read in order, at most keyframe_interval
+ */
+Frame &FrameStore::read(size_t i, Cursor &cursor) const {
+  size_t keyframe = i - i % keyframe_interval;
+  size_t next = cursor.index != SIZE_MAX and cursor.index >= keyframe and cursor.index <= i ? cursor.index + 1 : keyframe;
+  for (size_t f = next; f <= i; f++) {
+    decodeNext(blocks[locations[f].block].data() + locations[f].offset, cursor);
+  }
+  cursor.index = i;
+  return cursor.frame;
+}
+
+/// Returns the bytes the store holds on the heap, capacities included.
+size_t FrameStore::memoryUsage() const {
+  size_t bytes = blocks.capacity() * sizeof(blocks.front()) + locations.capacity() * sizeof(Location)
+               + record.capacity() + last_bar_of.capacity() * sizeof(uint32_t)
+               + (last_labels.capacity() + last_categories.capacity()) * sizeof(symbol_t)
+               + last_values.capacity() * sizeof(value_t);
+  for (const auto &block : blocks) bytes += block.capacity();
+  return bytes;
+}
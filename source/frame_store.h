@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>          // std::vector
+#include <algorithm>       // std::max
+#include <cstdint>         // uint8_t, uint32_t, SIZE_MAX
+#include <cstddef>         // size_t
+#include "barchart.h"      // Frame, value_t
+#include "symbol_table.h"  // symbol_t
+
+/**
+ * @brief Frames kept in memory in a compressed form, decoded on demand.
+ *
+ * Consecutive frames usually list the same entities with values that barely change, so
+ * most frames are stored as the changes from the previous one: each bar points to the bar
+ * of the previous frame with the same label (usually at the same index, in a single byte),
+ * and integer values are stored as the difference with that bar's value, as a zigzag varint.
+ * Bars that are new, or changed category, are stored whole. Values that are not integers
+ * are stored as they are, in 8 bytes.
+ *
+ * Every keyframe_interval-th frame is a keyframe, stored against an empty frame, so any
+ * frame can be decoded from the keyframe before it, with at most keyframe_interval - 1 deltas.
+ * A Cursor remembers the last frame it decoded, so frames read in order only cost a delta each.
+ *
+ * Encoded frames are appended to blocks of BLOCK_SIZE bytes, which never move once written,
+ * so the store grows without reallocating what it holds.
+ *
+ * Record of a frame (every number is a varint):
+ *   timestamp | title | x label | source | # of bars
+ *   | per bar: 0, label, category (a new bar, whose previous value is 0)
+ *              or 1 + zigzag(index in the previous frame - index) (a known bar),
+ *              then zigzag(value - previous value) * 2, or 1 and the value's 8 bytes
+ */
+class FrameStore {
+  public:
+  static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+  /// @brief Decodes frames into a Frame, resuming from the last one when it can.
+  class Cursor {
+    friend class FrameStore;
+    Frame frame;                      ///< The last frame decoded
+    size_t index = SIZE_MAX;          ///< Its index, SIZE_MAX if none
+    vector<symbol_t> labels;          ///< Bars of the frame being decoded
+    vector<symbol_t> categories;
+    vector<value_t> values;
+  };
+
+  private:
+  static constexpr uint32_t NO_BAR = UINT32_MAX;
+
+  /// @brief Where a frame's record starts.
+  struct Location {
+    uint32_t block;
+    uint32_t offset;
+  };
+
+  size_t keyframe_interval;
+  std::vector<std::vector<uint8_t>> blocks; ///< Encoded frames, never reallocated once full
+  std::vector<Location> locations;          ///< Record of each frame
+  std::vector<uint8_t> record;              ///< The record being encoded
+
+  // Bars of the last frame added, which the next one is encoded against
+  vector<symbol_t> last_labels;
+  vector<symbol_t> last_categories;
+  vector<value_t> last_values;
+  std::vector<uint32_t> last_bar_of;        ///< Bar of each label in the last frame, or NO_BAR
+  bool last_indexed = false;                ///< Whether last_bar_of was filled for the last frame
+
+  uint32_t findLast(symbol_t label, size_t i);
+  void decodeNext(const uint8_t *bytes, Cursor &cursor) const;
+
+  public:
+  explicit FrameStore(size_t keyframe_interval) : keyframe_interval(std::max<size_t>(1, keyframe_interval)) {}
+
+  void add(const Frame &frame);
+  Frame &read(size_t i, Cursor &cursor) const;
+  size_t size() const { return locations.size(); }
+  size_t memoryUsage() const;
+};
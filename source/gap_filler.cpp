@@ -0,0 +1,64 @@
+#include "gap_filler.h"
+
+#include <cmath>  // std::trunc, std::abs
+
+/**
+ * @brief Adds the entities seen in earlier frames that a frame does not list
+ *
+ * The bars the frame lists update the table and are left as they are. The missing
+ * entities are appended after them, in the order they were first seen, so a listed bar
+ * still ranks above a filled one with the same value.
+ *
+ * @param frame The frame that follows the last one filled
+ *
+ * Time Complexity: O(n + e) where n is the number of bars of the frame and e the number of entities
+ */
+void GapFiller::fill(Frame &frame) {
+  if (mode == Mode::NONE) return;
+  frame_number++;
+
+  const vector<symbol_t> &frame_labels = frame.getLabels();
+  const vector<symbol_t> &frame_categories = frame.getCategories();
+  const vector<value_t> &frame_values = frame.getValues();
+  const size_t n_listed = frame_labels.size();
+  for (size_t i = 0; i < n_listed; i++) {
+    symbol_t label = frame_labels[i];
+    if (label >= entity_of.size()) entity_of.resize(label + 1, NO_ENTITY);
+    uint32_t &entity = entity_of[label];
+    if (entity == NO_ENTITY) {
+      entity = labels.size();
+      labels.push_back(label);
+      categories.push_back(0);
+      values.push_back(0);
+      known.push_back(0);
+      listed_in.push_back(0);
+      shown.push_back(0);
+    }
+    categories[entity] = frame_categories[i];
+    values[entity] = known[entity] = frame_values[i];
+    listed_in[entity] = frame_number;
+    shown[entity] = 1;
+  }
+
+  // Missing entities are counted first, so the frame grows at most once, if it has no room for them.
+  size_t n_missing = 0;
+  for (size_t entity = 0; entity < labels.size(); entity++) {
+    n_missing += shown[entity] and listed_in[entity] != frame_number;
+  }
+  frame.reserveBars(n_listed + n_missing);
+
+  for (size_t entity = 0; entity < labels.size(); entity++) {
+    if (not shown[entity] or listed_in[entity] == frame_number) continue;
+    if (mode == Mode::DECAY) {
+      value_t decayed = values[entity] * decay;
+      // Series of whole numbers stay whole, so they end at 0.
+      if (std::trunc(known[entity]) == known[entity]) decayed = std::trunc(decayed);
+      values[entity] = decayed;
+      if (decayed == 0 or std::abs(decayed) < std::abs(known[entity]) / 1000) {
+        shown[entity] = 0;
+        continue;
+      }
+    }
+    frame.addBar(labels[entity], categories[entity], values[entity]);
+  }
+}
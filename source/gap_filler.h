@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>          // std::vector
+#include <cstdint>         // uint8_t, uint32_t
+#include "barchart.h"      // Frame, value_t
+#include "symbol_table.h"  // symbol_t
+
+/**
+ * @brief Fills the frames of a sparse input with the entities they do not list.
+ *
+ * Inputs often only have a row for an entity at the timestamps where it changed, so the
+ * entity vanishes from the frames in between and the race flickers. Frames are pushed in
+ * order and every entity seen so far is kept in a dense table, indexed by its label: an
+ * entity missing from a frame is added back to it with its last known value (CARRY), or
+ * with that value shrinking by a constant factor for every frame it stays missing (DECAY).
+ *
+ * The table is stored column by column, so filling a frame is a pass over a few flat
+ * arrays: O(entities) per frame. The table only allocates when a new entity shows up. The
+ * frame grows once to fit its missing bars, unless it already has room for every entity:
+ * the parser reserves it when it reads a frame after the previous ones were filled (not in
+ * parallel loads, where every frame is read before the first one is filled).
+ *
+ * Decayed entities leave the frames once their value becomes insignificant: when it falls
+ * under 1/1000 of their last known value, or to 0 for series of whole numbers, which stay
+ * whole as they decay. An entity listed again by a frame takes its listed value back.
+ *
+ * Usage:
+ * ```
+ *      GapFiller filler(GapFiller::Mode::DECAY, 0.9);
+ *      filler.fill(frame); // Adds the entities frame is missing, decayed
+ * ```
+ */
+class GapFiller {
+  public:
+  /// @brief What an entity missing from a frame is given.
+  enum class Mode { NONE, CARRY, DECAY };
+  /// @brief Fraction of its value a missing entity keeps per frame in DECAY mode, by default.
+  static constexpr double DEFAULT_DECAY = 0.9;
+
+  private:
+  static constexpr uint32_t NO_ENTITY = UINT32_MAX;
+
+  Mode mode;
+  double decay;                       ///< Fraction of its value a missing entity keeps per frame
+  uint32_t frame_number = 0;          ///< Number of frames filled so far
+
+  // Entities in the order they were first seen, column by column
+  std::vector<symbol_t> labels;
+  std::vector<symbol_t> categories;   ///< Category of the entity's last row
+  std::vector<value_t> values;        ///< Value given to the entity in the last frame
+  std::vector<value_t> known;         ///< Value of the entity's last row
+  std::vector<uint32_t> listed_in;    ///< Number of the last frame that listed the entity
+  std::vector<uint8_t> shown;         ///< Whether the entity is still added to the frames missing it
+  std::vector<uint32_t> entity_of;    ///< Entity of each label, or NO_ENTITY
+
+  public:
+  explicit GapFiller(Mode mode = Mode::NONE, double decay = DEFAULT_DECAY) : mode(mode), decay(decay) {}
+
+  void fill(Frame &frame);
+  bool enabled() const { return mode != Mode::NONE; }
+  /// Number of entities seen so far.
+  size_t size() const { return labels.size(); }
+};
@@ -0,0 +1,181 @@
+#include "layout.h"
+
+#include <algorithm>    // std::clamp, std::max
+#include <cmath>        // std::floor, std::abs
+#include <charconv>     // std::to_chars
+#include <string_view>  // std::string_view
+#include <csignal>      // sigaction, SIGWINCH
+#include <sys/ioctl.h>  // ioctl, TIOCGWINSZ, winsize
+#include <unistd.h>     // isatty, STDOUT_FILENO
+
+/**
+ * @brief Returns the geometry of a chart that fits in a terminal
+ *
+ * The bars and the axis take the whole width but LABEL_WIDTH columns, within
+ * [MIN_LENGTH, MAX_LENGTH], with a tick every TICK_SPACING columns. An 80 columns
+ * terminal gets the default geometry.
+ *
+ * @param columns The width of the terminal
+ */
+Geometry Geometry::forWidth(int columns) {
+  Geometry fitted;
+  fitted.bar_length = fitted.axis_length = std::clamp(columns - LABEL_WIDTH, MIN_LENGTH, MAX_LENGTH);
+  fitted.n_ticks = std::max(1, fitted.axis_length / TICK_SPACING);
+  return fitted;
+}
+
+/// Counts a resize. Only touches a lock-free atomic, so it is safe in a signal handler.
+void Layout::onResize(int) {
+  resizes.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Fits the geometry to the terminal the chart is written to, and follows its resizes
+ *
+ * Does nothing if the standard output is not a terminal, which keeps the default geometry
+ * (e.g. when the output is redirected to a file).
+ */
+void Layout::fitTerminal() {
+  if (not isatty(STDOUT_FILENO)) return;
+  if (not fitted) {
+    struct sigaction action = {};
+    action.sa_handler = onResize;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART; // Resizes must not interrupt reading keys or the input
+    sigaction(SIGWINCH, &action, nullptr);
+    fitted = true;
+  }
+  seen_resizes = resizeCount();
+  winsize size;
+  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 and size.ws_col > 0) geometry = Geometry::forWidth(size.ws_col);
+}
+
+/**
+ * @brief Fits the geometry to the terminal again if it was resized since the last call
+ *
+ * @return Whether the geometry changed
+ */
+bool Layout::update() {
+  if (not fitted or resizeCount() == seen_resizes) return false;
+  Geometry previous = geometry;
+  fitTerminal();
+  return not (geometry == previous);
+}
+
+/**
+ * @brief Appends a tick value as the axis prints it, without allocating
+ *
+ * Big numbers are shortened with a suffix (K for thousands, M for millions, B for billions,
+ * T for trillions), keeping one decimal under 10 (e.g. 9.4K). Small (or huge) numbers are
+ * written out, with up to two decimals the fewer digits they have.
+ */
+void Layout::appendTick(std::string &out, value_t number) {
+  char digits[64];
+  auto append_integer = [&] (long long integer) {
+    out.append(digits, std::to_chars(digits, digits + sizeof(digits), integer).ptr);
+  };
+  if (number >= 1e3 and number < 1e18) {
+    long long whole = static_cast<long long>(number);
+    auto shorten = [&] (long long unit, char suffix) {
+      append_integer(whole / unit);
+      out += '.';
+      append_integer(whole % unit / (unit / 10));
+      out += suffix;
+    };
+    auto truncate = [&] (long long unit, char suffix) {
+      append_integer(whole / unit);
+      out += suffix;
+    };
+    if (whole >= (long long)1e12) truncate(1e12, 'T');
+    else if (whole >= (long long)1e9) truncate(1e9, 'B');
+    else if (whole >= (long long)1e7) truncate(1e6, 'M');
+    else if (whole >= (long long)1e6) shorten(1e6, 'M');
+    else if (whole >= (long long)1e4) truncate(1000, 'K');
+    else shorten(1000, 'K');
+    return;
+  }
+  int precision = std::abs(number) < 10 ? 2 : std::abs(number) < 100 ? 1 : 0;
+  auto result = std::to_chars(digits, digits + sizeof(digits), number, std::chars_format::fixed, precision);
+  if (result.ec != std::errc()) result = std::to_chars(digits, digits + sizeof(digits), number, std::chars_format::scientific, 2);
+  std::string_view formatted(digits, result.ptr - digits);
+  if (formatted.find('.') != std::string_view::npos and formatted.find('e') == std::string_view::npos) {
+    while (formatted.back() == '0') formatted.remove_suffix(1);
+    if (formatted.back() == '.') formatted.remove_suffix(1);
+  }
+  out += formatted;
+}
+
+/**
+ * @brief Returns the x-axis of a chart, building it only if what it prints changed
+ *
+ * The value of the longest bar changes on almost every frame, but the tick values are
+ * rounded to what fits under the ticks, so most frames print the same axis. The tick
+ * labels are formatted (which allocates nothing) and compared to those of the cached axis.
+ *
+ * @param max_value The value of the longest bar
+ * @param max_length The length of the longest bar, in characters
+ * @return The axis (tick marks and values), valid until the next call
+ */
+const std::string &Layout::xAxis(value_t max_value, int max_length) {
+  const int axis_length = geometry.axis_length;
+  const int tick_separation = (axis_length-1) / geometry.n_ticks;
+  tick_labels.clear();
+  appendTick(tick_labels, 0); //Put the first tick on zero.
+  tick_labels += '\0';
+  for (int i = tick_separation; i < axis_length; i += tick_separation) {
+    value_t tick_value = max_length > 0 ? i * max_value / max_length : 0;
+    // Ticks of integer steps are whole numbers, decimals only matter for small scales.
+    if (max_value >= max_length) tick_value = std::floor(tick_value);
+    appendTick(tick_labels, tick_value);
+    tick_labels += '\0';
+  }
+
+  if (tick_labels != axis_labels or not (geometry == axis_geometry)) {
+    buildAxis();
+    n_builds++;
+    axis_geometry = geometry;
+    axis_labels = tick_labels;
+  }
+  return axis;
+}
+
+/**
+ * @brief Builds a string representation of the X-axis for the bar chart
+ *
+ * This function creates a horizontal axis with tick marks and the labels xAxis() formatted
+ * for them.
+ *
+ * The axis consists of two parts:
+ * 1. A line with '+' marks for ticks and '-' for the axis line, ending with '>'
+ * 2. Numeric values aligned under each tick mark
+ *
+ * Example output:
+ * +----+----+----+----+>
+ * 0    25K  50K  75K  100K
+ *
+ * @note The axis length and number of ticks are those of the geometry, and the labels
+ * those in tick_labels, one per tick, each followed by a '\0'
+ */
+void Layout::buildAxis() {
+  const int axis_length = geometry.axis_length;
+  const int tick_separation = (axis_length-1) / geometry.n_ticks;
+  axis.clear();
+  axis.reserve(2 * axis_length + tick_labels.size() + 16);
+
+  // Printing the Axis itself
+  axis += "+"; //Put the first tick on zero.
+  for (int i = 1; i < axis_length; i++) axis += i % tick_separation == 0 ? '+' : '-';
+  axis += ">\n";
+
+  // Printing the values
+  int currpos = 0, tick_location = 0;
+  for (size_t start = 0; start < tick_labels.size(); tick_location += tick_separation) {
+    size_t end = tick_labels.find('\0', start);
+    int space_count = std::max(0, tick_location - currpos);
+    axis.append(space_count, ' ');
+    axis.append(tick_labels, start, end - start);
+    currpos += space_count + (end - start);
+    start = end + 1;
+  }
+  axis += "\n";
+}
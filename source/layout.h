@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>   // std::string
+#include <atomic>   // std::atomic
+
+/// Type of the values of the bars. Integers are exact up to 2^53, far beyond any real series.
+using value_t = double;
+
+/// @brief How much room the chart takes on the terminal.
+struct Geometry {
+  static constexpr int DEFAULT_LENGTH = 60;   ///< Used when the output is not a terminal
+  static constexpr int MIN_LENGTH = 10;
+  static constexpr int MAX_LENGTH = 240;
+  static constexpr int LABEL_WIDTH = 20;      ///< Columns left after the longest bar for its label and value
+  static constexpr int TICK_SPACING = 6;      ///< Columns per tick on the x-axis
+
+  int bar_length = DEFAULT_LENGTH;            ///< Maximum number of characters a bar can occupy
+  int axis_length = DEFAULT_LENGTH;           ///< Length of the x-axis in characters
+  int n_ticks = DEFAULT_LENGTH / TICK_SPACING; ///< Number of tick marks on the x-axis
+
+  static Geometry forWidth(int columns);
+  bool operator==(const Geometry &other) const = default;
+};
+
+/**
+ * @brief Fits the chart to the terminal and caches what only depends on its size and scale.
+ *
+ * The geometry is computed once, from the width of the terminal (or the defaults when
+ * the output is not one), and again only when the terminal is resized: fitTerminal()
+ * installs a SIGWINCH handler which just counts resizes, and update() picks the new size
+ * up before the next frame is rendered.
+ *
+ * The x-axis (tick marks and tick values) only depends on the geometry and on the values
+ * printed under the ticks, which are rounded and shortened (e.g. 25K), so they stay the same
+ * while the longest bar grows a little. The last axis built is kept with its tick labels,
+ * and frames that print the same labels reuse it instead of building it again.
+ *
+ * A Layout is used by one thread at a time; threads rendering in parallel each use a copy.
+ */
+class Layout {
+  Geometry geometry;
+  unsigned seen_resizes = 0;          ///< Value of resizes when the geometry was computed
+  bool fitted = false;                ///< Whether the geometry follows the terminal
+
+  // Key and value of the cached axis
+  std::string axis;
+  Geometry axis_geometry;
+  std::string axis_labels;            ///< Tick labels of axis, each followed by a '\0' (empty while nothing is cached)
+  std::string tick_labels;            ///< Tick labels of the axis asked for last
+  size_t n_builds = 0;                ///< Number of axes built, the others came from the cache
+
+  static inline std::atomic<unsigned> resizes = 0;  ///< Number of SIGWINCH received
+  static void onResize(int);
+  static void appendTick(std::string &out, value_t number);
+  void buildAxis();
+
+  public:
+  Layout() = default;
+  explicit Layout(const Geometry &geometry) : geometry(geometry) {}
+
+  void fitTerminal();
+  bool update();
+  const Geometry &getGeometry() const { return geometry; }
+  const std::string &xAxis(value_t max_value, int max_length);
+  size_t axisBuilds() const { return n_builds; }
+  /// Number of times the terminal was resized since the program started.
+  static unsigned resizeCount() { return resizes.load(std::memory_order_relaxed); }
+};
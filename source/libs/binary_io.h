@@ -0,0 +1,84 @@
+#pragma once
+
+/**
+ * @file binary_io.h
+ * @brief Little endian integers for the binary files written by bcr.
+ * 
+ * Writers append to an std::ostream. Readers consume the front of a string_view, so a
+ * file can be parsed straight from its memory mapping.
+ * 
+ * Varints (7 bits per byte, the high bit set on every byte but the last) keep small
+ * numbers small in memory, and zigzag encoding keeps small negative numbers small too.
+ */
+#include <ostream>      // std::ostream
+#include <string_view>  // std::string_view
+#include <vector>       // std::vector
+#include <cstdint>      // uint32_t, uint64_t
+
+/// Writes a little endian 32-bit integer.
+inline void writeU32(std::ostream &out, uint32_t value) {
+  char bytes[4] = {char(value), char(value >> 8), char(value >> 16), char(value >> 24)};
+  out.write(bytes, 4);
+}
+
+/// Writes a little endian 64-bit integer.
+inline void writeU64(std::ostream &out, uint64_t value) {
+  writeU32(out, uint32_t(value));
+  writeU32(out, uint32_t(value >> 32));
+}
+
+/// Decodes the little endian 32-bit integer at bytes, which must hold at least 4 bytes.
+inline uint32_t decodeU32(const char *bytes) {
+  const auto *b = reinterpret_cast<const unsigned char*>(bytes);
+  return b[0] | b[1] << 8 | b[2] << 16 | uint32_t(b[3]) << 24;
+}
+
+/// Decodes the little endian 64-bit integer at bytes, which must hold at least 8 bytes.
+inline uint64_t decodeU64(const char *bytes) {
+  return uint64_t(decodeU32(bytes + 4)) << 32 | decodeU32(bytes);
+}
+
+/// Reads a little endian 32-bit integer from the front of data, consuming it.
+inline bool readU32(std::string_view &data, uint32_t &value) {
+  if (data.size() < 4) return false;
+  value = decodeU32(data.data());
+  data.remove_prefix(4);
+  return true;
+}
+
+/// Reads a little endian 64-bit integer from the front of data, consuming it.
+inline bool readU64(std::string_view &data, uint64_t &value) {
+  uint32_t low, high;
+  if (not readU32(data, low) or not readU32(data, high)) return false;
+  value = uint64_t(high) << 32 | low;
+  return true;
+}
+
+/// Appends an unsigned integer as a varint, in 1 to 10 bytes.
+inline void appendVarint(std::vector<uint8_t> &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(uint8_t(value) | 0x80);
+    value >>= 7;
+  }
+  out.push_back(uint8_t(value));
+}
+
+/// Decodes the varint at bytes, moving bytes past it. The varint must be complete.
+inline uint64_t decodeVarint(const uint8_t *&bytes) {
+  uint64_t value = 0;
+  for (int shift = 0; ; shift += 7) {
+    uint8_t byte = *bytes++;
+    value |= uint64_t(byte & 0x7F) << shift;
+    if (byte < 0x80) return value;
+  }
+}
+
+/// Maps signed integers to unsigned ones, small magnitudes first: 0, -1, 1, -2, 2...
+inline uint64_t zigzag(int64_t value) {
+  return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+/// Reverses zigzag().
+inline int64_t unzigzag(uint64_t value) {
+  return int64_t(value >> 1) ^ -int64_t(value & 1);
+}
@@ -1,32 +1,215 @@
 #include "coms.h"
 
+#include <mutex>              // std::mutex, std::lock_guard, std::unique_lock
+#include <condition_variable> // std::condition_variable
+#include <thread>             // std::thread
+#include <map>                // std::map
+#include <deque>              // std::deque
+#include <vector>             // std::vector
+
+/// Keeps messages logged from different threads from interleaving.
+/// Recursive, since the handlers std::exit runs after an error may print warnings too.
+static std::recursive_mutex output_mutex;
+
 inline std::ostream &operator<<(std::ostream &os, const Logger::SourceContext &sc) {
   os << sc.file << ":" << sc.line << "ª linha";
   return os;
 }
 
-void Logger::open_file(){
-  
+/**
+ * @brief Warnings with a source context, grouped by message and file.
+ * 
+ * Logging a warning only counts it in its group, so a file with thousands of bad lines
+ * costs a lookup per line instead of a flushed write to std::cerr. The groups are printed
+ * by flush(). When details are enabled, every warning (up to MAX_WARNING_DETAILS per group)
+ * is also queued for a background thread, which writes them to the log file in batches.
+ */
+class WarningLog {
+  struct Group {
+    std::string message;
+    std::string file;
+    size_t count = 0;
+    int first_line = 0;
+    int last_line = 0;
+  };
+  /// A warning waiting to be written to the log file.
+  struct Detail {
+    const Group *group;   ///< Groups never move nor go away, and their names never change
+    int line;
+    bool last;            ///< Whether the group reached MAX_WARNING_DETAILS with it
+  };
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::map<std::string, std::map<std::string, Group*>> index;  ///< Group of each message and file
+  std::deque<Group> groups;     ///< In order of first appearance, kept for good since details point to them
+  size_t n_flushed = 0;         ///< Groups already printed by flush()
+  std::vector<Detail> pending;  ///< Details not written yet
+  std::thread writer;
+  bool details = false;
+  int stopping = 0;             ///< Number of stop() calls waiting for the writer
+
+  /// Writes the pending details until stop() is called and nothing is left, then flushes the file.
+  void writeDetails() {
+    std::vector<Detail> batch;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      wake.wait(lock, [this] { return stopping > 0 or not pending.empty(); });
+      if (pending.empty()) {
+        // Only this thread writes to the file, and no other writer starts before it is joined.
+        lock.unlock();
+        Logger::file().flush();
+        return;
+      }
+      batch.swap(pending);
+      lock.unlock();
+      std::ostream &out = Logger::file();
+      for (const Detail &detail : batch) {
+        out << "Warning: \"" << detail.group->message << "\" at " << detail.group->file << ':' << detail.line << '\n';
+        if (detail.last) {
+          out << "Warning: further \"" << detail.group->message << "\" in " << detail.group->file << " are only counted\n";
+        }
+      }
+      batch.clear();
+      lock.lock();
+    }
+  }
+
+  /**
+   * @brief Waits for the writer to write every pending detail
+   *
+   * The writer is taken out under the lock and joined outside of it, so add() never sees
+   * it half stopped: while any stop() waits, add() only queues details. If some were
+   * queued meanwhile, a new writer is started for them.
+   *
+   * @return Whether a new writer was started
+   */
+  bool stop() {
+    std::thread stopped;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping++;
+      stopped.swap(writer);
+    }
+    wake.notify_all();
+    if (stopped.joinable()) stopped.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping--;
+    if (stopping == 0 and not pending.empty() and not writer.joinable()) {
+      writer = std::thread(&WarningLog::writeDetails, this);
+      return true;
+    }
+    return false;
+  }
+
+  public:
+  ~WarningLog() { while (stop()) {} }
+
+  void enableDetails(bool enable) {
+    std::lock_guard<std::mutex> lock(mutex);
+    details = enable;
+  }
+
+  void add(const std::string &message, const Logger::SourceContext &sc) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Group *&group = index[message][sc.file];
+    if (group == nullptr) group = &groups.emplace_back(Group{message, sc.file, 0, sc.line, sc.line});
+    group->count++;
+    // Parallel parsers report lines out of order.
+    group->first_line = std::min(group->first_line, sc.line);
+    group->last_line = std::max(group->last_line, sc.line);
+
+    if (details and group->count <= Logger::MAX_WARNING_DETAILS) {
+      if (stopping == 0 and not writer.joinable()) writer = std::thread(&WarningLog::writeDetails, this);
+      pending.push_back({group, sc.line, group->count == Logger::MAX_WARNING_DETAILS});
+      wake.notify_one();
+    }
+  }
+
+  /// Writes the remaining details, prints a summary of each group to out and forgets them.
+  void flush(std::ostream &out) {
+    // Details queued while stopping get a writer of their own, which is waited for too.
+    while (stop()) {}
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t n_groups = groups.size() - n_flushed;
+    size_t n_printed = std::min(n_groups, Logger::MAX_WARNING_GROUPS);
+    for (size_t i = n_flushed; i < n_flushed + n_printed; i++) {
+      const Group &group = groups[i];
+      out << std::endl << std::setw(80) << std::setfill('=') << " " << std::endl
+          << "Warning: " << TextFormat::applyFormat("\"" + group.message + "\"", Colors::YELLOW) << std::endl;
+      if (group.count == 1) {
+        out << "     REPORTED AT: < " << Logger::SourceContext(group.file, group.first_line) << " > \n";
+      } else {
+        out << "     REPORTED " << group.count << " TIMES, FROM < " << Logger::SourceContext(group.file, group.first_line)
+            << " > TO < " << Logger::SourceContext(group.file, group.last_line) << " > \n";
+      }
+      out << std::setw(80) << std::setfill('=') << " " << std::endl;
+    }
+    if (n_groups > n_printed) {
+      out << std::endl << std::setw(80) << std::setfill('=') << " " << std::endl
+          << "Warning: " << TextFormat::applyFormat("\"" + std::to_string(n_groups - n_printed)
+                                                    + " more kinds of warnings were only counted\"", Colors::YELLOW) << std::endl
+          << std::setw(80) << std::setfill('=') << " " << std::endl;
+    }
+    // Groups stay where they are, since details queued meanwhile may still point to them.
+    index.clear();
+    n_flushed = groups.size();
+  }
+};
+
+static WarningLog warning_log;
+
+std::ofstream Logger::logger_file;
+std::string Logger::logger_path;
+
+/**
+ * @brief Opens the log file, which file() writes to.
+ * 
+ * Opening the file that is already open keeps writing after what it has, any other file
+ * replaces it. Returns false if the file could not be created.
+ */
+bool Logger::open_file(const std::string &path) {
+  if (logger_file.is_open() and path == logger_path) return true;
+  if (logger_file.is_open()) logger_file.close();
+  logger_file.open(path);
+  logger_path = path;
+  return logger_file.is_open();
+}
+
+/// Whether every warning with a source context is also written, with its line, to the log file.
+void Logger::logWarningDetails(bool enable) {
+  warning_log.enableDetails(enable);
+}
+
+/// Prints the warnings logged since the last call, grouped by message and file.
+void Logger::flushWarnings() {
+  std::lock_guard<std::recursive_mutex> lock(output_mutex);
+  warning_log.flush(std::cerr);
 }
 
 /// Prints out the warning, but the program keeps running.
 void Logger::logWarning1(const std::string &msg) {
-
+  std::lock_guard<std::recursive_mutex> lock(output_mutex);
   std::cerr << std::endl << std::setw(80) << std::setfill('=') << " " << std::endl
             << "Warning: " << TextFormat::applyFormat("\"" + msg + "\"", Colors::YELLOW) << std::endl
             << std::setw(80) << std::setfill('=') << " " << std::endl;
 }
 
-/// Prints out the warning + source context, but the program keeps running.
+/**
+ * @brief Counts the warning + source context, but the program keeps running.
+ * 
+ * Warnings with the same message and file are printed together by flushWarnings(), with
+ * how many there were and the first and last lines reporting them.
+ */
 void Logger::logWarning2(const std::string &msg, const SourceContext &sc) {
-  std::cerr << std::endl << std::setw(80) << std::setfill('=') << " " << std::endl
-            << "Warning: " << TextFormat::applyFormat("\"" + msg + "\"", Colors::YELLOW) << std::endl
-            << "     REPORTED AT: < " << sc << " > \n"
-            << std::setw(80) << std::setfill('=') << " " << std::endl;
+  warning_log.add(msg, sc);
 }
 
 /// Prints out the error message and exits the program.
 void Logger::logError1(const std::string &msg) {
+  flushWarnings();
+  std::lock_guard<std::recursive_mutex> lock(output_mutex);
   std::cerr << std::endl << std::setw(80) << std::setfill('=') << " " << std::endl
             << "Severe error: " << TextFormat::applyFormat("\"" + msg + "\"", Colors::RED) << std::endl
             << "     exiting...\n"
@@ -37,6 +220,8 @@ void Logger::logError1(const std::string &msg) {
 
 /// Prints out the error message + source context, and exits the program.
 void Logger::logError2(const std::string &msg, const SourceContext &sc) {
+  flushWarnings();
+  std::lock_guard<std::recursive_mutex> lock(output_mutex);
   std::cerr << std::endl << std::setw(80) << std::setfill('=') << " " << std::endl
             << "Severe error: " << TextFormat::applyFormat("\"" + msg + "\"", Colors::RED) << std::endl
             << "     REPORTED AT: < " << sc << " > " << std::endl
@@ -48,5 +233,6 @@ void Logger::logError2(const std::string &msg, const SourceContext &sc) {
 
 /// Prints out a regular message.
 void Logger::logDebug(const std::string &str) {
+  std::lock_guard<std::recursive_mutex> lock(output_mutex);
   std::cout << TextFormat::applyFormat(">>> " + str, Colors::GREEN) << std::endl;
 }
@@ -10,7 +10,8 @@
 
 class Logger{
 private:
-  std::ofstream logger_file;
+  static std::ofstream logger_file;
+  static std::string logger_path;
 public:
   struct SourceContext
   {
@@ -23,7 +24,15 @@ public:
     ~SourceContext() = default;
   };
 
-  void open_file();
+  /// Most warnings of a single kind are summarized; past this many, the log file only counts them too.
+  static constexpr size_t MAX_WARNING_DETAILS = 1000;
+  /// Kinds of warnings printed by flushWarnings(), the rest are only counted.
+  static constexpr size_t MAX_WARNING_GROUPS = 16;
+
+  static bool open_file(const std::string &path);
+  static std::ostream &file() { return logger_file; }
+  static void logWarningDetails(bool enable);
+  static void flushWarnings();
   static void logError1(const std::string &message);
   static void logError2(const std::string &message, const SourceContext &sc);
   static void logWarning1(const std::string &message);
@@ -0,0 +1,184 @@
+#include "field_scanner.h"
+
+#include <algorithm>    // std::min
+#include <bit>          // std::countr_zero
+#include <cstring>      // std::memcpy, std::memset
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FIELD_SCANNER_X86
+#include <immintrin.h>  // _mm_cmpeq_epi8, _mm256_cmpeq_epi8, ...
+#endif
+
+namespace {
+
+constexpr size_t CHUNK = 64;  ///< Bytes classified at a time, one per bit of a mask
+
+/// @brief Where the characters that matter are in a chunk, one bit per byte.
+struct Masks {
+  uint64_t quotes = 0;
+  uint64_t commas = 0;
+  uint64_t newlines = 0;
+};
+
+/// One byte at a time, for CPUs without SIMD.
+inline Masks classifyScalar(const char *chunk) {
+  Masks masks;
+  for (size_t i = 0; i < CHUNK; i++) {
+    uint64_t bit = uint64_t(1) << i;
+    if (chunk[i] == '"') masks.quotes |= bit;
+    else if (chunk[i] == ',') masks.commas |= bit;
+    else if (chunk[i] == '\n') masks.newlines |= bit;
+  }
+  return masks;
+}
+
+#ifdef __SSE2__
+/// 16 bytes at a time, with SSE2 (every x86-64 CPU has it).
+inline Masks classifySSE2(const char *chunk) {
+  const __m128i quote = _mm_set1_epi8('"'), comma = _mm_set1_epi8(','), newline = _mm_set1_epi8('\n');
+  Masks masks;
+  for (size_t i = 0; i < CHUNK; i += 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(chunk + i));
+    masks.quotes |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote)))) << i;
+    masks.commas |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, comma)))) << i;
+    masks.newlines |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)))) << i;
+  }
+  return masks;
+}
+#endif
+
+#ifdef FIELD_SCANNER_X86
+/// 32 bytes at a time, with AVX2. Only called once the CPU is known to have it.
+__attribute__((target("avx2"))) inline Masks classifyAVX2(const char *chunk) {
+  const __m256i quote = _mm256_set1_epi8('"'), comma = _mm256_set1_epi8(','), newline = _mm256_set1_epi8('\n');
+  Masks masks;
+  for (size_t i = 0; i < CHUNK; i += 32) {
+    __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(chunk + i));
+    masks.quotes |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, quote)))) << i;
+    masks.commas |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, comma)))) << i;
+    masks.newlines |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline)))) << i;
+  }
+  return masks;
+}
+#endif
+
+/// Sets each bit to the XOR of itself and every bit below it.
+inline uint64_t prefixXor(uint64_t bits) {
+  for (int shift = 1; shift < 64; shift *= 2) bits ^= bits << shift;
+  return bits;
+}
+
+/**
+ * @brief Finds the separators of text with a classify function, a chunk at a time
+ *
+ * Always inlined, so each caller gets its own copy compiled for its instruction set.
+ * A byte is inside quotes if an odd number of quotes of its line come before it, or
+ * are it: the opening quote is inside, the closing one is not.
+ */
+template <Masks (*classify)(const char*)>
+__attribute__((always_inline)) inline void scanWith(std::string_view text, std::vector<uint32_t> &separators) {
+  uint64_t carry = 0; // All ones if the previous chunk ended inside quotes
+  alignas(CHUNK) char tail[CHUNK];
+
+  for (size_t base = 0; base < text.size(); base += CHUNK) {
+    const char *chunk = text.data() + base;
+    if (text.size() - base < CHUNK) {
+      // Zeros are neither quotes, commas nor line breaks.
+      std::memset(tail, 0, CHUNK);
+      std::memcpy(tail, chunk, text.size() - base);
+      chunk = tail;
+    }
+    Masks masks = classify(chunk);
+
+    uint64_t inside = prefixXor(masks.quotes) ^ carry;
+    // Lines that end inside quotes close them: the rest of the chunk is flipped back.
+    for (uint64_t open = masks.newlines & inside; open; open = masks.newlines & inside) {
+      inside ^= -(open & -open);
+    }
+    carry = -(inside >> 63);
+
+    for (uint64_t found = masks.commas & ~inside; found; found &= found - 1) {
+      separators.push_back(uint32_t(base + std::countr_zero(found)));
+    }
+  }
+}
+
+void scanScalar(std::string_view text, std::vector<uint32_t> &separators) {
+  scanWith<classifyScalar>(text, separators);
+}
+
+#ifdef __SSE2__
+void scanSSE2(std::string_view text, std::vector<uint32_t> &separators) {
+  scanWith<classifySSE2>(text, separators);
+}
+#endif
+
+#ifdef FIELD_SCANNER_X86
+__attribute__((target("avx2"))) void scanAVX2(std::string_view text, std::vector<uint32_t> &separators) {
+  scanWith<classifyAVX2>(text, separators);
+}
+#endif
+
+/// The level in use, the best one unless setLevel() was called.
+FieldScanner::Level &selected() {
+  static FieldScanner::Level level = FieldScanner::best();
+  return level;
+}
+
+} // namespace
+
+/// Returns the fastest level the CPU supports, detected once.
+FieldScanner::Level FieldScanner::best() {
+  static const Level detected = [] {
+#ifdef FIELD_SCANNER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return Level::AVX2;
+#endif
+#ifdef __SSE2__
+    return Level::SSE2;
+#else
+    return Level::SCALAR;
+#endif
+  }();
+  return detected;
+}
+
+/// Returns the level findSeparators() uses.
+FieldScanner::Level FieldScanner::level() {
+  return selected();
+}
+
+/// Makes findSeparators() use a level, or the best one the CPU supports if it is lower.
+/// @note Meant for benchmarks and checks, before any thread scans.
+void FieldScanner::setLevel(Level level) {
+  selected() = std::min(level, best());
+}
+
+const char *FieldScanner::name(Level level) {
+  switch (level) {
+    case Level::AVX2: return "avx2";
+    case Level::SSE2: return "sse2";
+    default: return "scalar";
+  }
+}
+
+/**
+ * @brief Finds the commas of text that are not inside quotes
+ *
+ * Text can hold any number of lines, the first one starting outside quotes.
+ *
+ * @param text The lines to scan, shorter than 4 GiB
+ * @param separators Receives the offsets of the separators in text, in ascending order
+ */
+void FieldScanner::findSeparators(std::string_view text, std::vector<uint32_t> &separators) {
+  separators.clear();
+  switch (selected()) {
+#ifdef FIELD_SCANNER_X86
+    case Level::AVX2: scanAVX2(text, separators); break;
+#endif
+#ifdef __SSE2__
+    case Level::SSE2: scanSSE2(text, separators); break;
+#endif
+    default: scanScalar(text, separators); break;
+  }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string_view>  // std::string_view
+#include <vector>       // std::vector
+#include <cstdint>      // uint32_t
+
+/**
+ * @brief Finds the field separators of comma-separated lines, 64 bytes at a time.
+ *
+ * Each 64 bytes of text are turned into bitmasks of their quotes, commas and line breaks,
+ * with SSE2 or AVX2 compares where the CPU has them (picked when the program starts) or one
+ * byte at a time otherwise. The quoted regions are found without looking at the bytes
+ * again: the prefix XOR of the quote mask has a bit set on every byte after an odd
+ * number of quotes, as in simdjson. Quotes do not span lines, so the state is reset after
+ * each line break that ends inside quotes. A separator is a comma outside the quotes.
+ *
+ * Doubled quotes inside quotes (e.g. "a ""b"" c") toggle the state twice, so they do not
+ * change where fields end: they only matter to the unquoting of the field.
+ *
+ * Usage:
+ * ```
+ *      std::vector<uint32_t> separators;
+ *      FieldScanner::findSeparators(lines, separators); // Offsets of the separators in lines
+ * ```
+ */
+class FieldScanner {
+  public:
+  /// @brief Instruction sets the scanner can use, from the slowest to the fastest.
+  enum class Level { SCALAR, SSE2, AVX2 };
+
+  static Level best();
+  static Level level();
+  static void setLevel(Level level);
+  static const char *name(Level level);
+  static void findSeparators(std::string_view text, std::vector<uint32_t> &separators);
+};
@@ -0,0 +1,67 @@
+#include "keyboard.h"
+
+#include <poll.h>       // poll
+#include <unistd.h>     // read, STDIN_FILENO
+#include <iostream>     // std::cin
+#include <algorithm>    // std::max
+
+/// Puts the terminal in raw mode. Ctrl+C is read as a key too, so it can be handled
+/// without leaving the terminal in raw mode.
+/// @return false if standard input is not a terminal
+bool Keyboard::enableRaw() {
+  if (raw) return true;
+  if (tcgetattr(STDIN_FILENO, &original) != 0) return false;
+  termios settings = original;
+  settings.c_lflag &= ~(ICANON | ECHO | ISIG);
+  settings.c_cc[VMIN] = 1;
+  settings.c_cc[VTIME] = 0;
+  if (tcsetattr(STDIN_FILENO, TCSANOW, &settings) != 0) return false;
+  raw = true;
+  return true;
+}
+
+/// Sets the terminal back the way it was before enableRaw().
+void Keyboard::restore() {
+  if (not raw) return;
+  tcsetattr(STDIN_FILENO, TCSANOW, &original);
+  raw = false;
+}
+
+/**
+ * @brief Waits for a key to be pressed
+ * 
+ * @param timeout How long to wait at most
+ * @return The character of the key, one of the Key values for arrows, Home and End,
+ *         or NONE if no key was pressed in time
+ */
+int Keyboard::waitKey(std::chrono::milliseconds timeout) {
+  pollfd input{STDIN_FILENO, POLLIN, 0};
+  if (poll(&input, 1, std::max<int>(0, timeout.count())) <= 0) return NONE;
+
+  // An escape sequence arrives all at once, so it is read in a single call.
+  char keys[16];
+  ssize_t n_read = read(STDIN_FILENO, keys, sizeof(keys));
+  if (n_read <= 0) return NONE;
+  if (n_read >= 3 and keys[0] == '\33' and (keys[1] == '[' or keys[1] == 'O')) {
+    switch (keys[2]) {
+      case 'A': return UP;
+      case 'B': return DOWN;
+      case 'C': return RIGHT;
+      case 'D': return LEFT;
+      case 'H': return HOME;
+      case 'F': return END;
+      default: return NONE;
+    }
+  }
+  return static_cast<unsigned char>(keys[0]);
+}
+
+/// Reads a whole line in the terminal's normal mode, then goes back to raw mode.
+std::string Keyboard::readLine() {
+  bool was_raw = raw;
+  restore();
+  std::string line;
+  std::getline(std::cin, line);
+  if (was_raw) enableRaw();
+  return line;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>       // std::string
+#include <chrono>       // std::chrono::milliseconds
+#include <termios.h>    // termios
+
+/**
+ * @brief Raw keystrokes from the terminal, read without waiting for Enter.
+ * 
+ * enableRaw() turns off line buffering and echo on standard input. The terminal is set
+ * back the way it was when the Keyboard is destroyed. Keys are read with a timeout, so
+ * a loop can wait for its next deadline and still react to a key as soon as it is pressed.
+ */
+class Keyboard {
+  termios original;     ///< Terminal settings before enableRaw()
+  bool raw = false;     ///< Whether the terminal is in raw mode
+
+  public:
+  /// Keys that send escape sequences, outside the range of plain characters.
+  enum Key : int { NONE = -1, LEFT = 256, RIGHT, UP, DOWN, HOME, END };
+
+  Keyboard() = default;
+  ~Keyboard() { restore(); }
+  Keyboard(const Keyboard&) = delete;
+  Keyboard &operator=(const Keyboard&) = delete;
+
+  bool enableRaw();
+  void restore();
+  int waitKey(std::chrono::milliseconds timeout);
+  std::string readLine();
+};
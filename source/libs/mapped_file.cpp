@@ -0,0 +1,49 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>      // open
+#include <sys/mman.h>   // mmap, munmap, madvise
+#include <sys/stat.h>   // fstat
+#include <unistd.h>     // close
+#include <utility>      // std::exchange
+
+/// Maps the whole file at path. An empty file is opened but has no mapping.
+/// Anything that is not a regular file (pipes, terminals...) is left unopened.
+MappedFile::MappedFile(const std::string &path, Access access) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return;
+
+  struct stat st;
+  if (::fstat(fd, &st) == 0 and S_ISREG(st.st_mode)) {
+    opened = true;
+    if (st.st_size > 0) {
+      void *addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        ::madvise(addr, st.st_size, access == Access::RANDOM ? MADV_RANDOM : MADV_SEQUENTIAL);
+        bytes = static_cast<const char*>(addr);
+        n_bytes = st.st_size;
+      } else {
+        opened = false;
+      }
+    }
+  }
+  ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (bytes) ::munmap(const_cast<char*>(bytes), n_bytes);
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept :
+  bytes(std::exchange(other.bytes, nullptr)),
+  n_bytes(std::exchange(other.n_bytes, 0)),
+  opened(std::exchange(other.opened, false)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    if (bytes) ::munmap(const_cast<char*>(bytes), n_bytes);
+    bytes = std::exchange(other.bytes, nullptr);
+    n_bytes = std::exchange(other.n_bytes, 0);
+    opened = std::exchange(other.opened, false);
+  }
+  return *this;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>       // std::string
+#include <string_view>  // std::string_view
+#include <cstddef>      // size_t
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ * 
+ * The mapping is released when the object is destroyed. Views returned by view()
+ * stay valid for as long as the MappedFile that produced them is alive.
+ * 
+ * The kernel is told how the mapping will be read, so it reads ahead (and frees the pages
+ * already read) for files walked front to back, and only loads the pages touched otherwise.
+ */
+class MappedFile {
+  const char *bytes = nullptr;  ///< Start of the mapping (nullptr if not mapped)
+  size_t n_bytes = 0;           ///< Size of the mapping in bytes
+  bool opened = false;          ///< Whether the file could be opened
+
+  public:
+  /// @brief How the mapping will be read.
+  enum class Access {
+    SEQUENTIAL,   ///< Front to back, once (e.g. an input being parsed)
+    RANDOM        ///< Anywhere, in any order (e.g. the frames of a compiled dataset)
+  };
+
+  MappedFile() = default;
+  explicit MappedFile(const std::string &path, Access access = Access::SEQUENTIAL);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile &operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  bool isOpen() const { return opened; }
+  size_t size() const { return n_bytes; }
+  std::string_view view() const { return {bytes, n_bytes}; }
+};
@@ -0,0 +1,48 @@
+#include "profiler.h"
+
+#include <cstdlib>  // std::malloc, std::free
+#include <new>      // std::bad_alloc
+
+/**
+ * @brief Writes every counter and phase as a JSON object
+ * 
+ * Example output:
+ * {"counters": {"bytes_read": 1024, ...}, "phases": {"parse": {"calls": 40, "seconds": 0.0012}, ...}}
+ */
+void Profiler::writeJSON(std::ostream &out) {
+  out << "{\"counters\": {";
+  for (int i = 0; i < N_COUNTERS; i++) {
+    out << (i ? ", " : "") << '"' << COUNTER_NAMES[i] << "\": " << counters[i].load();
+  }
+  out << "}, \"phases\": {";
+  for (int i = 0; i < N_PHASES; i++) {
+    out << (i ? ", " : "") << '"' << PHASE_NAMES[i] << "\": {\"calls\": " << phase_calls[i].load()
+        << ", \"seconds\": " << phase_nanoseconds[i].load() / 1e9 << '}';
+  }
+  out << "}}\n";
+}
+
+/**
+ * @brief Writes every counter and phase as CSV
+ * 
+ * Example output:
+ * kind,name,calls,value
+ * counter,bytes_read,,1024
+ * phase,parse,40,0.0012
+ */
+void Profiler::writeCSV(std::ostream &out) {
+  out << "kind,name,calls,value\n";
+  for (int i = 0; i < N_COUNTERS; i++) out << "counter," << COUNTER_NAMES[i] << ",," << counters[i].load() << '\n';
+  for (int i = 0; i < N_PHASES; i++) {
+    out << "phase," << PHASE_NAMES[i] << ',' << phase_calls[i].load() << ',' << phase_nanoseconds[i].load() / 1e9 << '\n';
+  }
+}
+
+// Allocations are counted by replacing the global operator new (and the matching deletes).
+void *operator new(std::size_t size) {
+  Profiler::add(Profiler::ALLOCATIONS);
+  if (void *memory = std::malloc(size ? size : 1)) return memory;
+  throw std::bad_alloc();
+}
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>        // std::array
+#include <atomic>       // std::atomic
+#include <chrono>       // std::chrono::steady_clock
+#include <cstdint>      // uint64_t
+#include <ostream>      // std::ostream
+
+/**
+ * @brief Counters and phase timers, to find out where a run spends its time.
+ * 
+ * Everything is off until enable() is called, and then every counter and timer can be
+ * updated from any thread. While disabled, add() and Scope cost a single relaxed load
+ * and a branch, so they can stay in the code for good.
+ * 
+ * Usage:
+ * ```
+ *      Profiler::enable();
+ *      {
+ *        Profiler::Scope scope(Profiler::PARSE); // Time until the end of the block
+ *        Profiler::add(Profiler::BARS, n_bars);
+ *      }
+ *      Profiler::writeJSON(file);
+ * ```
+ */
+class Profiler {
+  public:
+  using clock = std::chrono::steady_clock;
+
+  enum Counter {
+    BYTES_READ,       ///< Bytes of the input read by the parser
+    LINES,            ///< Lines of the input read by the parser
+    TOKENS,           ///< Tokens of the bar lines
+    BARS,             ///< Bars parsed
+    FRAMES,           ///< Frames parsed
+    FRAMES_SHOWN,     ///< Frames written to the terminal
+    DROPPED_FRAMES,   ///< Frames dropped for being late
+    RENDER_BYTES,     ///< Bytes produced by Frame::render
+    ALLOCATIONS,      ///< Calls to operator new
+    N_COUNTERS
+  };
+
+  enum Phase {
+    LOAD,     ///< Reading the whole input
+    PARSE,    ///< Parsing a frame
+    RENDER,   ///< Rendering a frame
+    WRITE,    ///< Writing a frame to the terminal
+    WAIT,     ///< Waiting for the next frame's turn
+    N_PHASES
+  };
+
+  /// @brief Adds the time from its construction to its destruction to a phase.
+  class Scope {
+    Phase phase;
+    bool active;
+    clock::time_point start;
+
+    public:
+    explicit Scope(Phase phase) : phase(phase), active(enabled()) {
+      if (active) start = clock::now();
+    }
+    ~Scope() {
+      if (active) record(phase, clock::now() - start);
+    }
+    Scope(const Scope&) = delete;
+    Scope &operator=(const Scope&) = delete;
+  };
+
+  static void enable() { is_enabled.store(true, std::memory_order_relaxed); }
+  static bool enabled() { return is_enabled.load(std::memory_order_relaxed); }
+
+  static void add(Counter counter, uint64_t amount = 1) {
+    if (enabled()) counters[counter].fetch_add(amount, std::memory_order_relaxed);
+  }
+  static void record(Phase phase, clock::duration elapsed) {
+    phase_calls[phase].fetch_add(1, std::memory_order_relaxed);
+    phase_nanoseconds[phase].fetch_add(std::chrono::nanoseconds(elapsed).count(), std::memory_order_relaxed);
+  }
+
+  static void writeJSON(std::ostream &out);
+  static void writeCSV(std::ostream &out);
+
+  private:
+  static inline std::atomic<bool> is_enabled{false};
+  static inline std::array<std::atomic<uint64_t>, N_COUNTERS> counters{};
+  static inline std::array<std::atomic<uint64_t>, N_PHASES> phase_calls{};
+  static inline std::array<std::atomic<uint64_t>, N_PHASES> phase_nanoseconds{};
+
+  static constexpr const char *COUNTER_NAMES[N_COUNTERS] = {
+    "bytes_read", "lines", "tokens", "bars", "frames", "frames_shown", "dropped_frames", "render_bytes", "allocations"
+  };
+  static constexpr const char *PHASE_NAMES[N_PHASES] = {"load", "parse", "render", "write", "wait"};
+};
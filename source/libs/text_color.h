@@ -9,10 +9,21 @@
  *                << Color::tcolor("texto em vermelho e negrito", Colors::RED, Modifiers::BOLD)
  *                << "\n";
  * ```
+ * 
+ * For text that is formatted over and over (like the frames of the animation), StyledBuffer
+ * appends everything to a single reusable buffer instead:
+ * ```c++
+ *      StyledBuffer out;
+ *      out.append("texto em vermelho e negrito", Colors::RED, Modifiers::BOLD);
+ *      out.appendPlain("\n");
+ *      std::cout << out.finish();
+ * ```
  */
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <array>
+#include <charconv>  // std::to_chars
 
 using std::ostringstream;
 using std::string;
@@ -64,9 +75,173 @@ public:
    * @param modifier Modifier code to apply to the message.
    * @return A string with the embedded color/modifier escape codes.
    */
-  static std::string applyFormat(const std::string &msg, short color = Colors::WHITE, short modifier = Modifiers::REGULAR) {
+  static std::string applyFormat(std::string_view msg, short color = Colors::WHITE, short modifier = Modifiers::REGULAR) {
     ostringstream oss;
     oss << "\33[" << modifier << ";" << color << "m" << msg << "\33[0m";
     return oss.str();
   }
 };
+
+
+/// @brief An escape sequence selecting one (color, modifier) pair, stored inline.
+struct EscapeCode {
+  char text[12] = {};
+  unsigned char size = 0;
+
+  constexpr void put(char c) { text[size++] = c; }
+  constexpr void putNumber(int number) {
+    if (number >= 10) put('0' + number / 10);
+    put('0' + number % 10);
+  }
+
+  /// Builds "\33[<modifier>;<color>m", preceded by a reset ("0;") if requested.
+  static constexpr EscapeCode build(color_t color, mod_t modifier, bool reset) {
+    EscapeCode code;
+    code.put('\33');
+    code.put('[');
+    if (reset and modifier != Modifiers::REGULAR) {
+      code.put('0');
+      code.put(';');
+    }
+    code.putNumber(modifier);
+    code.put(';');
+    code.putNumber(color);
+    code.put('m');
+    return code;
+  }
+
+  using table_t = array<array<EscapeCode, Modifiers::MODIFIERS.size()>, Colors::COLORS.size()>;
+
+  /// Builds the sequence of every (color, modifier) pair, indexed like Colors::COLORS and Modifiers::MODIFIERS.
+  static constexpr table_t buildTable(bool reset) {
+    table_t table{};
+    for (size_t c = 0; c < Colors::COLORS.size(); c++) {
+      for (size_t m = 0; m < Modifiers::MODIFIERS.size(); m++) {
+        table[c][m] = build(Colors::COLORS[c], Modifiers::MODIFIERS[m], reset);
+      }
+    }
+    return table;
+  }
+};
+
+/// @brief Precomputed escape sequences selecting each (color, modifier) pair.
+class EscapeCodes {
+  static constexpr EscapeCode::table_t SET = EscapeCode::buildTable(false);  ///< Sequences adding to the current style
+  static constexpr EscapeCode::table_t RESET = EscapeCode::buildTable(true); ///< Sequences clearing the current style first
+
+  static constexpr size_t colorIndex(color_t color) {
+    for (size_t i = 0; i < Colors::COLORS.size(); i++) if (Colors::COLORS[i] == color) return i;
+    return 0;
+  }
+  static constexpr size_t modifierIndex(mod_t modifier) {
+    for (size_t i = 0; i < Modifiers::MODIFIERS.size(); i++) if (Modifiers::MODIFIERS[i] == modifier) return i;
+    return 0;
+  }
+
+public:
+  /// Returns the sequence switching to (color, modifier).
+  /*!
+   * @param reset Whether attributes set by previous sequences must be cleared
+   */
+  static constexpr std::string_view get(color_t color, mod_t modifier, bool reset) {
+    const EscapeCode &code = (reset ? RESET : SET)[colorIndex(color)][modifierIndex(modifier)];
+    return {code.text, code.size};
+  }
+};
+
+/**
+ * @brief Appends ANSI formatted text to a single reusable buffer.
+ * 
+ * Unlike TextFormat::applyFormat, nothing is allocated once the buffer is big enough, and
+ * escape sequences are only emitted when the style actually changes: consecutive spans
+ * with the same (color, modifier) share a single sequence, and the style is reset once
+ * at the end instead of after every span.
+ */
+class StyledBuffer {
+  std::string buffer;             ///< The formatted text
+  bool styled = false;            ///< Whether a style is active
+  color_t color = Colors::WHITE;  ///< Active color (if styled)
+  mod_t modifier = Modifiers::REGULAR; ///< Active modifier (if styled)
+
+  void setStyle(color_t new_color, mod_t new_modifier) {
+    if (styled and new_color == color and new_modifier == modifier) return;
+    // Switching from one modifier to another has to clear the first one.
+    bool reset = styled and modifier != Modifiers::REGULAR and modifier != new_modifier;
+    buffer += EscapeCodes::get(new_color, new_modifier, reset);
+    styled = true;
+    color = new_color;
+    modifier = new_modifier;
+  }
+
+public:
+  /// Empties the buffer, keeping its memory.
+  void clear() {
+    buffer.clear();
+    styled = false;
+  }
+
+  /// Appends text with the given style.
+  void append(std::string_view text, color_t text_color = Colors::WHITE, mod_t text_modifier = Modifiers::REGULAR) {
+    setStyle(text_color, text_modifier);
+    buffer += text;
+  }
+
+  /// Appends count copies of c with the given style.
+  void appendFill(size_t count, char c, color_t text_color, mod_t text_modifier = Modifiers::REGULAR) {
+    setStyle(text_color, text_modifier);
+    buffer.append(count, c);
+  }
+
+  /// Appends a number with the given style.
+  void appendNumber(long long number, color_t text_color, mod_t text_modifier = Modifiers::REGULAR) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    append(std::string_view(digits, result.ptr - digits), text_color, text_modifier);
+  }
+
+  /// Appends a number with the given style, with as few decimals as it needs and no exponent.
+  void appendDecimal(double number, color_t text_color, mod_t text_modifier = Modifiers::REGULAR) {
+    char digits[64];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number, std::chars_format::fixed);
+    // Huge numbers do not fit in fixed notation.
+    if (result.ec != std::errc()) result = std::to_chars(digits, digits + sizeof(digits), number);
+    append(std::string_view(digits, result.ptr - digits), text_color, text_modifier);
+  }
+
+  /// Appends unformatted text.
+  /*!
+   * Line breaks and tabs do not paint anything, so they are written without leaving a
+   * bold or regular style. Anything else clears the active style first.
+   */
+  void appendPlain(std::string_view text) {
+    if (styled) {
+      bool paints = modifier != Modifiers::REGULAR and modifier != Modifiers::BOLD;
+      for (size_t i = 0; not paints and i < text.size(); i++) paints = text[i] != '\n' and text[i] != '\t';
+      if (paints) {
+        buffer += "\33[0m";
+        styled = false;
+      }
+    }
+    buffer += text;
+  }
+
+  /// Appends a control sequence that does not paint anything (like a cursor movement).
+  void appendControl(std::string_view sequence) { buffer += sequence; }
+
+  /// Clears the active style, if any.
+  void resetStyle() {
+    if (styled) {
+      buffer += "\33[0m";
+      styled = false;
+    }
+  }
+
+  /// Clears the active style and returns the whole text.
+  std::string_view finish() {
+    resetStyle();
+    return buffer;
+  }
+
+  std::string_view view() const { return buffer; }
+  size_t size() const { return buffer.size(); }
+};
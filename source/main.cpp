@@ -2,32 +2,176 @@
 #include <vector>
 #include <iostream>
 #include <memory>
+#include <thread>
+#include <chrono>
+#include <iomanip>
+#include <type_traits>
 
 #include "animation.h"
 #include "file_parser.h"
+#include "frame_merger.h"
+#include "libs/profiler.h"
 
 using std::cout;
 
 void printUsage();
 void printWelcome();
-void readInput(FileParser& parser, std::shared_ptr<AnimationManager> animation);
+template <typename Input> void readInput(Input& parser, std::shared_ptr<AnimationManager> animation);
+template <typename Input> std::thread streamInput(Input& parser, std::shared_ptr<AnimationManager> animation);
+string inputNames();
+void replayCache(std::shared_ptr<AnimationManager> animation);
+void readCompiled(std::shared_ptr<AnimationManager> animation);
+void exportCharts(std::shared_ptr<AnimationManager> animation);
+void writeProfile();
 void parseArgs(int argc, char **argv);
 
 int fps = 24;
 int bars = 5;
-string filepath = "";
+int jobs = std::max(1u, std::thread::hardware_concurrency());
+int stream_depth = 0; // 0 reads the whole file before playing
+int render_ahead = -1; // -1 renders each frame when displayed, 0 renders all of them first
+string cache_path = ""; // Where to save the rendered frames instead of playing them
+string compile_path = ""; // Where to save the compiled dataset instead of playing it
+int tween_steps = 0; // # of in-between frames played between two frames of the input
+bool diff_output = false; // Whether only the cells that changed between frames are written
+bool interactive = false; // Whether the animation is controlled with the keyboard
+string export_path = ""; // Where to export the frames instead of playing them
+string profile_path = ""; // Where to write the counters and timings at exit
+string log_path = ""; // Where to write every warning about the input
+bool follow = false; // Whether the input keeps being read as it grows
+int keyframe_interval = 0; // 0 keeps the charts as they are, otherwise they are compressed with a keyframe every <num>
+GapFiller::Mode gap_mode = GapFiller::Mode::NONE; // What the entities missing from a chart are given
+double gap_decay = GapFiller::DEFAULT_DECAY; // Fraction of its value a missing entity keeps per chart, when decaying
+constexpr int FOLLOW_DEPTH = 64; // Queue depth of a followed input, unless -s says otherwise
+string filepath = ""; // The first input file
+std::vector<string> filepaths; // Every input file, merged into a single race if there are several
 
 int main(int argc, char **argv) {
   parseArgs(argc, argv);
+  if (not profile_path.empty()) {
+    Profiler::enable();
+    // Also runs when an error exits the program, so a failed run can be profiled too.
+    std::atexit(writeProfile);
+  }
+  if (not log_path.empty()) {
+    if (not Logger::open_file(log_path)) Logger::logError1("Could not create the log file \"" + log_path + "\".");
+    Logger::logWarningDetails(true);
+  }
+  // Warnings about the input are printed once it was read, or at exit if it was streamed.
+  std::atexit(Logger::flushWarnings);
   printWelcome();
 
   std::shared_ptr<AnimationManager> animation = std::make_shared<AnimationManager>();
+  if (filepaths.size() > 1) {
+    for (const string &path : filepaths) {
+      if (FrameCache::isCacheFile(path) or CompiledDataset::isCompiledFile(path)) {
+        Logger::logError1("Only input data files can be merged, \"" + path + "\" is not one.");
+      }
+    }
+  } else if (FrameCache::isCacheFile(filepath)) {
+    replayCache(animation);
+    return EXIT_SUCCESS;
+  }
+  // Probed once: every probe opens the file again.
+  const bool compiled_input = filepaths.size() == 1 and CompiledDataset::isCompiledFile(filepath);
+
+  if (follow) {
+    if (filepaths.size() > 1 or compiled_input or interactive or not export_path.empty()
+        or not cache_path.empty() or not compile_path.empty() or render_ahead == 0) {
+      Logger::logWarning1("Only the plain playback of a single input data file can follow it. Reading it until its current end.\n");
+      follow = false;
+    } else if (stream_depth == 0) {
+      // Charts are played as they are appended, so they are streamed.
+      stream_depth = FOLLOW_DEPTH;
+    }
+  }
+  if (interactive and stream_depth > 0) {
+    Logger::logWarning1("Interactive playback needs every chart in memory. Reading the whole file first.\n");
+    stream_depth = 0;
+  }
+  if (not export_path.empty() and stream_depth > 0) {
+    Logger::logWarning1("Exporting renders charts in parallel, which needs every chart in memory. Reading the whole file first.\n");
+    stream_depth = 0;
+  }
+
+  if (keyframe_interval > 0 and (stream_depth > 0 or not compile_path.empty()
+                                 or compiled_input)) {
+    Logger::logWarning1("Only charts read from input data files into memory are compressed. Keeping them as they are.\n");
+    keyframe_interval = 0;
+  }
+
+  if (gap_mode != GapFiller::Mode::NONE) {
+    if (compiled_input) {
+      Logger::logWarning1("Missing bars are only filled while reading input data files. Compile the data with -g instead.\n");
+    } else {
+      animation->setGapFilling(gap_mode, gap_decay);
+    }
+  }
+
   FileParser parser(filepath, animation);
-  readInput(parser, animation);
+  FrameMerger merger(filepaths, animation);
+  // Several files are merged into a single race, a single one is parsed directly.
+  auto withInput = [&] (auto &&action) {
+    if (filepaths.size() > 1) action(merger);
+    else action(parser);
+  };
+  std::thread producer;
+  if (not compile_path.empty()) {
+    withInput([&] (auto &input) {
+      input.setJobs(jobs);
+      readInput(input, animation);
+    });
+    if (not animation->saveCompiled(compile_path)) {
+      Logger::logError1("Could not write the compiled dataset to \"" + compile_path + "\".");
+    }
+    cout << ">>> " << animation->numberCharts() << " charts compiled to \"" << compile_path << "\".\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (compiled_input) {
+    readCompiled(animation);
+  } else if (stream_depth > 0) {
+    // Frames are parsed in file order as they are played, so a single parsing thread is enough.
+    animation->enableStreaming(stream_depth);
+    animation->setLive(follow);
+    withInput([&] (auto &input) { producer = streamInput(input, animation); });
+  } else {
+    if (keyframe_interval > 0) animation->enableCompression(keyframe_interval);
+    withInput([&] (auto &input) {
+      input.setJobs(jobs);
+      readInput(input, animation);
+    });
+  }
+
+  animation->setTweenSteps(tween_steps);
+  if (not cache_path.empty()) {
+    animation->prerenderAll(bars);
+    if (producer.joinable()) producer.join();
+    if (not animation->getRendered().save(cache_path)) {
+      Logger::logError1("Could not write the rendered charts to \"" + cache_path + "\".");
+    }
+    cout << ">>> " << animation->getRendered().size() << " charts rendered to \"" << cache_path << "\".\n";
+    return EXIT_SUCCESS;
+  }
+  animation->setDiffOutput(diff_output);
+  if (not export_path.empty()) {
+    exportCharts(animation);
+    return EXIT_SUCCESS;
+  }
+  if (interactive) {
+    cout << "Press enter to begin the animation.\n";
+    std::cin.ignore();
+    animation->PlayInteractive(fps, bars);
+    return EXIT_SUCCESS;
+  }
+  if (render_ahead == 0) animation->prerenderAll(bars);
+  else if (render_ahead > 0) animation->setRenderAhead(render_ahead);
   
   //Wait for Enter to be pressed
+  cout << "Press enter to begin the animation.\n";
   std::cin.ignore();
   animation->PlayAnimation(fps,bars);
+  if (producer.joinable()) producer.join();
 
   return EXIT_SUCCESS;
 }
@@ -37,19 +181,72 @@ int main(int argc, char **argv) {
  * @brief Prints the usage information for the Bar Chart Race program and exits
  * 
  * Displays command line options and their descriptions including:
- * - Input data file requirement
+ * - Input data file requirement, and the merge of several input data files
  * - -b option for maximum number of bars (range 1-15, default 5)
  * - -f option for animation speed in fps (range 1-24, default 24)
+ * - -j option for the number of threads parsing the input (range 1-256, default # of cores)
+ * - -s option for streaming the input with a queue of <num> frames (range 1-4096)
+ * - -r option for rendering <num> frames ahead, or all of them if 0 (range 0-4096)
+ * - -w option for saving the rendered frames to a file instead of playing them
+ * - -t option for the # of in-between frames played between two charts (range 0-60, default 0)
+ * - -o option for the output mode: "full" redraws or "diff" (only changed cells)
+ * - -z option for compressing the charts in memory, with a keyframe every <num> (range 1-4096)
+ * - -g option for filling the bars missing from a chart: "carry" or "decay[:<factor>]"
+ * - --compile option for compiling an input data file into a binary dataset
+ * - --interactive option for controlling the animation with the keyboard
+ * - --export option for rendering the charts to files instead of playing them
+ * - --profile option for writing counters and phase timings to a file at exit
+ * - --log option for writing every warning about the input to a file
+ * - --follow option for playing the charts appended to the input file as it grows
  * 
  * After printing usage information, the program exits with status code 1.
  */
 void printUsage() {
-  std::cout << "Usage: bcr [<options>] <input_data_file>\n";
+  std::cout << "Usage: bcr [<options>] <input_data_file>...\n";
+  std::cout << "       bcr [<options>] <rendered_charts_file>\n";
+  std::cout << "       bcr [<options>] <compiled_dataset_file>\n";
+  std::cout << "       bcr --compile <input_data_file> <compiled_dataset_file>\n";
+  std::cout << "Several input data files (e.g. one per region) are merged into a single race:\n";
+  std::cout << "the bars of the charts with the same timestamp are shown together.\n";
   std::cout << "Bar Chart Race options:\n";
   std::cout << "\t-b <num> Max # of bars in a single char.\n";
   std::cout << "\t\tValid range is [1,15]. Default value is 5.\n";
   std::cout << "\t-f <num> Animation speed in fps (frames per second).\n";
-  std::cout << "\t\tValid range is [1,24]; Default value is 24.";
+  std::cout << "\t\tValid range is [1,24]; Default value is 24.\n";
+  std::cout << "\t-j <num> # of threads used to parse the input file.\n";
+  std::cout << "\t\tValid range is [1,256]; Default value is the # of cores.\n";
+  std::cout << "\t-s <num> Stream the input: play charts while the file is read,\n";
+  std::cout << "\t\tkeeping at most <num> of them in memory. Valid range is [1,4096].\n";
+  std::cout << "\t\tBy default the whole file is read before the animation starts.\n";
+  std::cout << "\t-r <num> Render charts on a separate thread, up to <num> ahead of the one\n";
+  std::cout << "\t\tdisplayed, or all of them before the animation starts if <num> is 0.\n";
+  std::cout << "\t\tValid range is [0,4096]. By default each chart is rendered when displayed.\n";
+  std::cout << "\t-w <file> Render every chart into <file> instead of playing them.\n";
+  std::cout << "\t\tPassing <file> as the input replays the charts without reading the data again.\n";
+  std::cout << "\t-t <num> # of in-between frames played between two charts, so bars move smoothly.\n";
+  std::cout << "\t\tValid range is [0,60]. Default value is 0.\n";
+  std::cout << "\t-o <mode> How each chart replaces the previous one on the terminal: \"full\" redraws\n";
+  std::cout << "\t\tthe whole chart, \"diff\" only rewrites what changed. Default value is full.\n";
+  std::cout << "\t-z <num> Keep the charts compressed in memory, each one stored as its changes from\n";
+  std::cout << "\t\tthe previous one but every <num>-th, and decode them as they are played.\n";
+  std::cout << "\t\tValid range is [1,4096]. By default charts are kept as they are.\n";
+  std::cout << "\t-g <mode> Fill the entities missing from a chart with their last value: \"carry\" keeps it,\n";
+  std::cout << "\t\t\"decay\" or \"decay:<factor>\" multiplies it by <factor> for every chart they\n";
+  std::cout << "\t\tstay missing, in (0,1), 0.9 by default. By default missing entities are not shown.\n";
+  std::cout << "\t--compile <input_data_file> <compiled_dataset_file> Compile the input into a binary\n";
+  std::cout << "\t\tfile, which is played like the input but starts without parsing anything.\n";
+  std::cout << "\t--interactive Control the animation with the keyboard: pause, step back and forth,\n";
+  std::cout << "\t\tchange the speed and go to any timestamp.\n";
+  std::cout << "\t--export <path> Render every chart on -j threads and write them to <path> without\n";
+  std::cout << "\t\twaiting: an asciicast recording if it ends in .cast, one file per chart if it\n";
+  std::cout << "\t\tis a directory (or ends in /), or the raw terminal output otherwise.\n";
+  std::cout << "\t--profile <file> Count bytes, lines, bars, frames, allocations... and time each\n";
+  std::cout << "\t\tphase (load, parse, render, write, wait), writing them to <file> at exit.\n";
+  std::cout << "\t\tThe file is JSON if its name ends in .json, and CSV otherwise.\n";
+  std::cout << "\t--log <file> Write every warning about the input to <file>, with its line.\n";
+  std::cout << "\t\tThe terminal only gets a summary of each kind of warning either way.\n";
+  std::cout << "\t--follow Keep reading the input data file as it grows, playing new charts as they\n";
+  std::cout << "\t\tare appended, until Ctrl+C is pressed. Streams the input (-s 64 by default).";
   std::cout << std::endl;
   exit(0);
 }
@@ -71,27 +268,157 @@ void printWelcome() {
  * - Retrieves metadata (title, axis label, source)
  * - Displays summary information about the animation
  * 
- * @param parser FileParser object that handles reading and parsing the input file
+ * @param parser FileParser (or FrameMerger, for several files) that handles reading and parsing the input
  * @param animation Shared pointer to AnimationManager that will handle the animation sequence
  * 
  * @pre Input file path must be valid and accessible
  * @post Animation manager will be initialized with parsed data
  * 
- * @note Function will prompt user to press enter before beginning animation
  */
-void readInput(FileParser& parser, std::shared_ptr<AnimationManager> animation){
-  cout << ">>> Preparing to read input file \"" << filepath << "\"...\n\n";
+template <typename Input>
+void readInput(Input& parser, std::shared_ptr<AnimationManager> animation){
+  cout << ">>> Preparing to read input " << inputNames() << "...\n\n";
   cout << ">>> Processing data, please wait.\n";
 
   auto [title, x_axis_label, source] = parser.loadFile();
+  Logger::flushWarnings();
   cout << ">>> Input file successfully read.\n";
   cout << ">>> We have " << animation->numberCharts() << " charts, each with " << bars << " bars.\n\n";
   cout << ">>> Animation Speed is " << fps << " fps.\n";
+  if (tween_steps > 0) cout << ">>> " << tween_steps << " in-between frames are played between two charts.\n";
   cout << ">>> Title: " << title << '\n';
   cout << ">>> X axis label: " << x_axis_label << '\n';
   cout << ">>> Source: " << source << '\n';
   cout << ">>> # of categories found: " << animation->numberCategories() << '\n';
+}
+
+/*!
+ * @brief Starts reading the input data while the animation is played
+ * 
+ * Only the header is read before returning. The frames are parsed by a separate thread
+ * that feeds them to the animation manager's queue, blocking whenever the queue is full.
+ * The number of charts and categories is not known in advance, so it is not displayed.
+ * 
+ * @param parser FileParser (or FrameMerger, for several files) that handles reading and parsing the input
+ * @param animation Shared pointer to an AnimationManager in streaming mode
+ * 
+ * @return The thread reading the frames, which finishes once the whole file was read
+ */
+template <typename Input>
+std::thread streamInput(Input& parser, std::shared_ptr<AnimationManager> animation) {
+  cout << ">>> Preparing to stream input " << inputNames() << "...\n\n";
+
+  auto [title, x_axis_label, source] = parser.loadHeader();
+  std::thread producer([&parser, animation] () {
+    if constexpr (std::is_same_v<Input, FileParser>) {
+      if (follow) parser.followFrames(); // Only returns if the input is a pipe that was closed
+      else parser.loadFrames();
+    } else {
+      parser.loadFrames();
+    }
+    animation->endOfStream();
+  });
+
+  if (follow) cout << ">>> New charts are played as they are appended to the file. Press Ctrl+C to stop.\n";
+  cout << ">>> Charts are played while they are read, up to " << stream_depth << " ahead.\n";
+  cout << ">>> Each chart has " << bars << " bars.\n\n";
+  cout << ">>> Animation Speed is " << fps << " fps.\n";
+  if (tween_steps > 0) cout << ">>> " << tween_steps << " in-between frames are played between two charts.\n";
+  cout << ">>> Title: " << title << '\n';
+  cout << ">>> X axis label: " << x_axis_label << '\n';
+  cout << ">>> Source: " << source << '\n';
+  return producer;
+}
+
+/*!
+ * @brief Opens a dataset compiled by a previous run with the --compile option
+ * 
+ * Only the strings of the dataset are loaded, its charts are decoded while they are played.
+ * 
+ * @param animation Shared pointer to the AnimationManager that will play the charts
+ */
+void readCompiled(std::shared_ptr<AnimationManager> animation) {
+  cout << ">>> Preparing to read compiled dataset \"" << filepath << "\"...\n\n";
+  if (not animation->openCompiled(filepath)) {
+    Logger::logError1("The compiled dataset is corrupted or was written by another version of bcr.");
+  }
+  const SymbolTable &symbols = animation->getSymbols();
+  const CompiledDataset &compiled = animation->getCompiled();
+  cout << ">>> Compiled dataset successfully read.\n";
+  cout << ">>> We have " << animation->numberCharts() << " charts, each with " << bars << " bars.\n\n";
+  cout << ">>> Animation Speed is " << fps << " fps.\n";
+  if (tween_steps > 0) cout << ">>> " << tween_steps << " in-between frames are played between two charts.\n";
+  cout << ">>> Title: " << symbols.name(compiled.getTitle()) << '\n';
+  cout << ">>> X axis label: " << symbols.name(compiled.getXLabel()) << '\n';
+  cout << ">>> Source: " << symbols.name(compiled.getSource()) << '\n';
+  cout << ">>> # of categories found: " << animation->numberCategories() << '\n';
+}
+
+/*!
+ * @brief Renders every chart to files, without waiting for anything
+ * 
+ * The charts are rendered on as many threads as the -j option says and written in order,
+ * then the throughput is reported.
+ * 
+ * @param animation Shared pointer to the AnimationManager holding every chart
+ */
+void exportCharts(std::shared_ptr<AnimationManager> animation) {
+  FrameExporter exporter(export_path, fps);
+  if (not exporter.open()) {
+    Logger::logError1("Could not create \"" + export_path + "\" to export the charts to.");
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  animation->ExportAnimation(exporter, bars, jobs);
+  if (not exporter.close()) {
+    Logger::logError1("Could not write every chart to \"" + export_path + "\".");
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  cout << std::fixed << std::setprecision(2);
+  cout << ">>> Exported " << exporter.size() << " charts to \"" << export_path << "\" in " << seconds << " s: "
+       << exporter.size() / std::max(seconds, 1e-9) << " fps on " << jobs << " threads.\n";
+}
+
+/*!
+ * @brief Writes the Profiler's counters and timings to the --profile file, at exit
+ * 
+ * It may run from Logger::logError1/2, which holds the Logger's lock while exiting, so
+ * errors are written straight to std::cerr instead of going through the Logger.
+ */
+void writeProfile() {
+  if (not Logger::open_file(profile_path)) {
+    std::cerr << "Could not write the profile to \"" << profile_path << "\".\n";
+    return;
+  }
+  bool json = profile_path.size() >= 5 and profile_path.compare(profile_path.size() - 5, 5, ".json") == 0;
+  if (json) Profiler::writeJSON(Logger::file());
+  else Profiler::writeCSV(Logger::file());
+  Logger::file().flush();
+}
+
+/*!
+ * @brief Plays charts rendered by a previous run with the -w option
+ * 
+ * The charts are written out as they were saved, so the -b option has no effect here.
+ * 
+ * @param animation Shared pointer to the AnimationManager that will play the charts
+ */
+void replayCache(std::shared_ptr<AnimationManager> animation) {
+  cout << ">>> Preparing to replay rendered charts from \"" << filepath << "\"...\n\n";
+
+  FrameCache cache;
+  if (not cache.load(filepath)) {
+    Logger::logError1("The rendered charts file is corrupted or was written by another version of bcr.");
+  }
+  cout << ">>> We have " << cache.size() << " rendered charts.\n\n";
+  cout << ">>> Animation Speed is " << fps << " fps.\n";
   cout << "Press enter to begin the animation.\n";
+
+  //Wait for Enter to be pressed
+  std::cin.ignore();
+  animation->setDiffOutput(diff_output);
+  animation->PlayRendered(cache, fps);
 }
 
 /**
@@ -100,7 +427,21 @@ void readInput(FileParser& parser, std::shared_ptr<AnimationManager> animation){
  * @details Processes command line arguments to set up program configuration:
  *          -b: Number of bars (1-15, default: 5)
  *          -f: Frames per second (1-24, default: 24)
- *          Also accepts a filepath as a non-flag argument
+ *          -j: Parsing threads (1-256, default: # of cores)
+ *          -s: Streaming queue depth (1-4096, default: no streaming)
+ *          -r: Frames rendered ahead, 0 for all (0-4096, default: none)
+ *          -w: File to save the rendered frames to
+ *          -t: In-between frames (0-60, default: 0)
+ *          -o: Output mode, full or diff (default: full)
+ *          -z: Keyframe interval of the compressed charts (1-4096, default: no compression)
+ *          -g: Filling of missing bars, carry or decay[:<factor>] (default: none)
+ *          --compile: Input data file and the file to compile it into
+ *          --interactive: Controls the animation with the keyboard
+ *          --export: File or directory to export the charts to
+ *          --profile: File to write the counters and timings to
+ *          --log: File to write every warning to
+ *          --follow: Keeps reading the input as it grows
+ *          Also accepts filepaths as non-flag arguments, merging the files if there are several
  * 
  * @param argc Number of command line arguments
  * @param argv Array of command line argument strings
@@ -110,6 +451,13 @@ void readInput(FileParser& parser, std::shared_ptr<AnimationManager> animation){
  * @note If invalid arguments are provided, defaults to:
  *       - 5 bars for invalid -b argument
  *       - 24 fps for invalid -f argument
+ *       - # of cores for invalid -j argument
+ *       - no streaming for invalid -s argument
+ *       - no rendering ahead for invalid -r argument
+ *       - no in-between frames for invalid -t argument
+ *       - full redraws for invalid -o argument
+ *       - no compression for invalid -z argument
+ *       - no filling for invalid -g argument
  *       Will print usage information if no arguments or invalid flags are provided
  */
 void parseArgs(int argc, char **argv) {
@@ -118,7 +466,37 @@ void parseArgs(int argc, char **argv) {
     return;
   } else {
     for (int arg_n = 1; arg_n < argc; arg_n++) {
-      if (argv[arg_n][0] == '-') {
+      if (string(argv[arg_n]) == "--compile") {
+        if (arg_n + 2 >= argc) {
+          printUsage();
+          return;
+        }
+        filepaths.push_back(argv[arg_n+1]);
+        compile_path = argv[arg_n+2];
+        arg_n += 2;
+      } else if (string(argv[arg_n]) == "--export") {
+        if (arg_n + 1 >= argc) {
+          printUsage();
+          return;
+        }
+        export_path = argv[++arg_n];
+      } else if (string(argv[arg_n]) == "--profile") {
+        if (arg_n + 1 >= argc) {
+          printUsage();
+          return;
+        }
+        profile_path = argv[++arg_n];
+      } else if (string(argv[arg_n]) == "--log") {
+        if (arg_n + 1 >= argc) {
+          printUsage();
+          return;
+        }
+        log_path = argv[++arg_n];
+      } else if (string(argv[arg_n]) == "--follow") {
+        follow = true;
+      } else if (string(argv[arg_n]) == "--interactive") {
+        interactive = true;
+      } else if (argv[arg_n][0] == '-') {
         switch (argv[arg_n][1]) {
           case 'b':
             try {
@@ -144,12 +522,129 @@ void parseArgs(int argc, char **argv) {
               Logger::logWarning1("Argument for fps is out of range. Using default value of 24 fps.\n");
             } 
             break;
+          case 'j':
+            try {
+              int n_jobs = std::stoi(argv[arg_n+1]);
+              if (n_jobs < 1 || n_jobs > 256) {
+                throw std::out_of_range("Out of range");
+              }
+              jobs = n_jobs;
+            } catch (std::invalid_argument&) {
+              Logger::logWarning1("Invalid argument for jobs. Using one thread per core.\n");
+            } catch (std::out_of_range&) {
+              Logger::logWarning1("Argument for jobs is out of range. Using one thread per core.\n");
+            }
+            break;
+          case 's':
+            try {
+              int depth = std::stoi(argv[arg_n+1]);
+              if (depth < 1 || depth > 4096) {
+                throw std::out_of_range("Out of range");
+              }
+              stream_depth = depth;
+            } catch (std::invalid_argument&) {
+              Logger::logWarning1("Invalid argument for streaming. Reading the whole file first.\n");
+            } catch (std::out_of_range&) {
+              Logger::logWarning1("Argument for streaming is out of range. Reading the whole file first.\n");
+            }
+            break;
+          case 'r':
+            try {
+              int ahead = std::stoi(argv[arg_n+1]);
+              if (ahead < 0 || ahead > 4096) {
+                throw std::out_of_range("Out of range");
+              }
+              render_ahead = ahead;
+            } catch (std::invalid_argument&) {
+              Logger::logWarning1("Invalid argument for rendering ahead. Rendering each chart when displayed.\n");
+            } catch (std::out_of_range&) {
+              Logger::logWarning1("Argument for rendering ahead is out of range. Rendering each chart when displayed.\n");
+            }
+            break;
+          case 'w':
+            if (arg_n + 1 >= argc) {
+              printUsage();
+              return;
+            }
+            cache_path = argv[arg_n+1];
+            break;
+          case 't':
+            try {
+              int steps = std::stoi(argv[arg_n+1]);
+              if (steps < 0 || steps > 60) {
+                throw std::out_of_range("Out of range");
+              }
+              tween_steps = steps;
+            } catch (std::invalid_argument&) {
+              Logger::logWarning1("Invalid argument for in-between frames. Playing the charts as they are.\n");
+            } catch (std::out_of_range&) {
+              Logger::logWarning1("Argument for in-between frames is out of range. Playing the charts as they are.\n");
+            }
+            break;
+          case 'o':
+            if (arg_n + 1 >= argc) {
+              printUsage();
+              return;
+            }
+            if (string(argv[arg_n+1]) == "diff") diff_output = true;
+            else if (string(argv[arg_n+1]) == "full") diff_output = false;
+            else Logger::logWarning1("Invalid argument for the output mode. Redrawing whole charts.\n");
+            break;
+          case 'z':
+            try {
+              int interval = std::stoi(argv[arg_n+1]);
+              if (interval < 1 || interval > 4096) {
+                throw std::out_of_range("Out of range");
+              }
+              keyframe_interval = interval;
+            } catch (std::invalid_argument&) {
+              Logger::logWarning1("Invalid argument for compression. Keeping the charts as they are.\n");
+            } catch (std::out_of_range&) {
+              Logger::logWarning1("Argument for compression is out of range. Keeping the charts as they are.\n");
+            }
+            break;
+          case 'g': {
+            if (arg_n + 1 >= argc) {
+              printUsage();
+              return;
+            }
+            string mode = argv[arg_n+1];
+            if (mode == "carry") {
+              gap_mode = GapFiller::Mode::CARRY;
+            } else if (mode == "decay") {
+              gap_mode = GapFiller::Mode::DECAY;
+            } else if (mode.starts_with("decay:")) {
+              try {
+                double factor = std::stod(mode.substr(6));
+                if (not (factor > 0 and factor < 1)) {
+                  throw std::out_of_range("Out of range");
+                }
+                gap_mode = GapFiller::Mode::DECAY;
+                gap_decay = factor;
+              } catch (std::invalid_argument&) {
+                Logger::logWarning1("Invalid decay factor for the missing bars. Leaving them out.\n");
+              } catch (std::out_of_range&) {
+                Logger::logWarning1("Decay factor for the missing bars is out of range. Leaving them out.\n");
+              }
+            } else {
+              Logger::logWarning1("Invalid argument for the missing bars. Leaving them out.\n");
+            }
+            break;
+          }
           default:
             printUsage();
           return;
         }
         arg_n++;
-      } else filepath = argv[arg_n];
+      } else filepaths.push_back(argv[arg_n]);
     }  
   }
+  if (not filepaths.empty()) filepath = filepaths.front();
+}
+
+/// Names the input files, quoted, for the messages about reading them.
+string inputNames() {
+  string names = filepaths.size() > 1 ? "files " : "file ";
+  for (size_t i = 0; i < filepaths.size(); i++) names += (i ? ", \"" : "\"") + filepaths[i] + '"';
+  return names;
 }
\ No newline at end of file
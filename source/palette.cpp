@@ -0,0 +1,11 @@
+#include "palette.h"
+
+#include <algorithm>  // std::lower_bound
+
+/// Inserts a category in the legend, keeping it sorted by name.
+void Palette::addToLegend(symbol_t category) {
+  std::string_view category_name = names.name(category);
+  auto position = std::lower_bound(legend.begin(), legend.end(), category_name,
+    [this] (symbol_t other, std::string_view name) { return names.name(other) < name; });
+  legend.insert(position, category);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string_view>        // std::string_view
+#include <vector>             // std::vector
+#include "symbol_table.h"     // SymbolTable, symbol_t
+#include "libs/text_color.h"  // color_t, Colors
+
+/**
+ * @brief Category names and the colors assigned to them.
+ * 
+ * Categories are interned in their own SymbolTable, so their IDs are dense and colors
+ * can be kept in a flat array indexed by category ID. Interning can happen on any
+ * thread, but colors are only assigned by assign(), which must be called in file order
+ * so every run gives each category the same color.
+ */
+class Palette {
+  static constexpr color_t NO_COLOR = -1;   ///< Color of a category not assigned yet
+
+  SymbolTable names;          ///< Category names, indexed by category ID
+  std::vector<color_t> colors;  ///< Color of each category, indexed by category ID
+  std::vector<symbol_t> legend; ///< Assigned categories, in alphabetical order
+
+  void addToLegend(symbol_t category);
+
+  public:
+  symbol_t intern(std::string_view category) { return names.intern(category); }
+  std::string_view name(symbol_t category) const { return names.name(category); }
+
+  /// Gives a category the next color, unless it already has one.
+  void assign(symbol_t category) {
+    if (category < colors.size() and colors[category] != NO_COLOR) return;
+    if (category >= colors.size()) colors.resize(category + 1, NO_COLOR);
+    colors[category] = Colors::COLORS[legend.size() % Colors::COLORS.size()];
+    addToLegend(category);
+  }
+  color_t color(symbol_t category) const { return colors[category]; }
+  const std::vector<symbol_t> &getLegend() const { return legend; }
+  size_t size() const { return legend.size(); }
+  bool empty() const { return legend.empty(); }
+};
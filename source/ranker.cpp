@@ -0,0 +1,76 @@
+#include "ranker.h"
+
+#include <algorithm>  // std::min
+
+/**
+ * @brief Finds the bar of the frame being ranked with the label of a bar of the last frame.
+ * 
+ * The bar at the same index is checked first. Otherwise the labels of the frame are
+ * indexed in bar_of, at most once per frame.
+ * 
+ * @return The bar's index, or NO_BAR if the frame has no bar with that label
+ */
+uint32_t Ranker::findBar(const Frame &frame, const Ranked &ranked) {
+  const vector<symbol_t> &labels = frame.getLabels();
+  if (ranked.bar < labels.size() and labels[ranked.bar] == ranked.label) return ranked.bar;
+  if (not indexed) {
+    bar_of.assign(bar_of.size(), NO_BAR);
+    for (uint32_t bar = 0; bar < labels.size(); bar++) {
+      if (labels[bar] >= bar_of.size()) bar_of.resize(labels[bar] + 1, NO_BAR);
+      bar_of[labels[bar]] = bar;
+    }
+    indexed = true;
+  }
+  return ranked.label < bar_of.size() ? bar_of[ranked.label] : NO_BAR;
+}
+
+/**
+ * @brief Ranks the n_top highest bars of a frame, and remembers them for the next one.
+ * 
+ * Frames without enough bars in common with the previous one are ranked from scratch.
+ * 
+ * @param frame The frame to rank
+ * @param n_top The number of bars displayed, which is all that has to be ranked
+ * 
+ * Time Complexity: O(n + c + m) where n is the number of bars, c the number of candidates
+ * and m the number of positions they moved since the previous frame
+ */
+void Ranker::rank(Frame &frame, size_t n_top) {
+  const vector<symbol_t> &labels = frame.getLabels();
+  const vector<value_t> &values = frame.getValues();
+  n_top = std::min(n_top, labels.size());
+
+  indexed = false;
+  seed.clear();
+  placed.assign(labels.size(), false);
+  value_t threshold = 0;
+  for (const Ranked &ranked : previous) {
+    uint32_t bar = findBar(frame, ranked);
+    // A label listed twice (in either frame) only places one bar.
+    if (bar == NO_BAR or placed[bar]) continue;
+    threshold = seed.empty() ? values[bar] : std::min(threshold, values[bar]);
+    seed.push_back(bar);
+    placed[bar] = true;
+  }
+
+  if (n_top == 0 or seed.size() < n_top) {
+    frame.sortBars(n_top);
+  } else {
+    // The n_top seeded bars all reach the threshold, so the bars displayed do too.
+    // Candidates go after the seeded bars, the others fill the seed from its end.
+    size_t front = seed.size(), back = labels.size();
+    seed.resize(labels.size());
+    for (uint32_t bar = 0; bar < labels.size(); bar++) {
+      if (placed[bar]) continue;
+      if (values[bar] >= threshold) seed[front++] = bar;
+      else seed[--back] = bar;
+    }
+    frame.sortBarsFrom(seed, front, n_top);
+  }
+
+  previous.clear();
+  for (size_t rank = 0; rank < n_top; rank++) {
+    uint32_t bar = frame.getOrder()[rank];
+    previous.push_back({labels[bar], bar});
+  }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>          // std::vector
+#include <cstdint>         // uint32_t
+#include "barchart.h"      // Frame
+#include "symbol_table.h"  // symbol_t
+
+/**
+ * @brief Ranks the bars of consecutive frames, starting each one from the previous ranking.
+ * 
+ * Bars are matched across frames by label (usually found at the same index, as data files
+ * tend to list the entities in the same order every time). The bars that were displayed in the previous
+ * frame are still there in the next one, so the lowest of their new values is a lower
+ * bound for the values displayed next: only the bars that reach it can be displayed.
+ * Those candidates are seeded in their previous order (the new ones after them) and
+ * Frame::sortBarsFrom() repairs what changed. When consecutive frames only swap a few
+ * positions, this costs a scan of the values plus a few moves, instead of a sort.
+ * 
+ * Ties break the same way as in Frame::sortBars(), so the ranking of a frame does not
+ * depend on the previous one, and frames can be ranked in any order.
+ */
+class Ranker {
+  static constexpr uint32_t NO_BAR = UINT32_MAX;
+
+  /// @brief A bar ranked in the last frame.
+  struct Ranked {
+    symbol_t label;
+    uint32_t bar;   ///< Its index, which is usually the same in the next frame
+  };
+
+  std::vector<Ranked> previous;     ///< Bars ranked in the last frame, by rank
+  std::vector<uint32_t> bar_of;     ///< Bar of each label in the frame being ranked, or NO_BAR
+  std::vector<uint32_t> seed;       ///< Order the frame being ranked starts from
+  std::vector<bool> placed;         ///< Whether each bar of the frame being ranked is in the seed
+  bool indexed = false;             ///< Whether bar_of was filled for the frame being ranked
+
+  uint32_t findBar(const Frame &frame, const Ranked &ranked);
+
+  public:
+  void rank(Frame &frame, size_t n_top);
+};
@@ -0,0 +1,176 @@
+#include "screen.h"
+
+#include <cstring>  // std::memcmp
+#include <string>   // std::to_string
+
+/// Cells are equal if they look the same: unstyled blanks match any blank that paints nothing.
+bool Screen::Cell::operator==(const Cell &other) const {
+  if (size != other.size or std::memcmp(text, other.text, size) != 0) return false;
+  if (not styled and not other.styled) return true;
+  return styled == other.styled and color == other.color and modifier == other.modifier;
+}
+
+/**
+ * @brief Lays rendered text out into a grid of cells
+ * 
+ * @param frame Text made of characters, line breaks, tabs and SGR sequences
+ * @param grid Receives one row of cells per line
+ */
+void Screen::layout(std::string_view frame, std::vector<row_t> &grid) {
+  for (auto &row : grid) row.clear();
+  size_t row = 0;
+  Cell pen; // Style applied to the next character
+
+  auto put = [&] (const Cell &cell) {
+    if (grid.size() <= row) grid.resize(row + 1);
+    grid[row].push_back(cell);
+  };
+
+  for (size_t i = 0; i < frame.size(); i++) {
+    char c = frame[i];
+    if (c == '\n') {
+      row++;
+      if (grid.size() <= row) grid.resize(row + 1);
+    } else if (c == '\t') {
+      // Tabs paint nothing: the cells they skip are blank.
+      size_t col = grid.size() > row ? grid[row].size() : 0;
+      for (size_t n = TAB_WIDTH - col % TAB_WIDTH; n > 0; n--) put(Cell{});
+    } else if (c == '\33') {
+      // SGR sequence: "\33[" numbers separated by ';' and a final 'm'
+      size_t end = frame.find('m', i);
+      if (end == std::string_view::npos) break;
+      int number = 0;
+      for (size_t j = i + 2; j <= end; j++) {
+        if (frame[j] >= '0' and frame[j] <= '9') {
+          number = number * 10 + (frame[j] - '0');
+          continue;
+        }
+        if (number == 0) {
+          pen.styled = false;
+          pen.modifier = Modifiers::REGULAR;
+        } else if ((number >= 30 and number <= 37) or (number >= 90 and number <= 97)) {
+          pen.styled = true;
+          pen.color = number;
+        } else {
+          pen.modifier = number;
+        }
+        number = 0;
+      }
+      i = end;
+    } else {
+      Cell cell = pen;
+      // A UTF-8 character is its lead byte followed by continuation bytes (10xxxxxx).
+      cell.size = 0;
+      do {
+        cell.text[cell.size++] = frame[i++];
+      } while (i < frame.size() and cell.size < 4 and (frame[i] & 0xC0) == 0x80);
+      i--;
+      put(cell);
+    }
+  }
+  // A trailing line break does not start a row with anything in it.
+  while (not grid.empty() and grid.back().empty()) grid.pop_back();
+}
+
+/// Moves the cursor with relative movements.
+void Screen::moveTo(size_t row, size_t col) {
+  if (row > cursor_row) out.appendControl("\33[" + std::to_string(row - cursor_row) + "B");
+  else if (row < cursor_row) out.appendControl("\33[" + std::to_string(cursor_row - row) + "A");
+
+  if (col != cursor_col) {
+    if (col == 0) out.appendControl("\r");
+    else if (col > cursor_col) out.appendControl("\33[" + std::to_string(col - cursor_col) + "C");
+    else out.appendControl("\33[" + std::to_string(cursor_col - col) + "D");
+  }
+  cursor_row = row;
+  cursor_col = col;
+}
+
+/// Writes the cells [begin, end) of a row at the cursor, which must be at begin.
+void Screen::writeCells(const row_t &row, size_t begin, size_t end) {
+  for (size_t col = begin; col < end; col++) {
+    const Cell &cell = row[col];
+    std::string_view text(cell.text, cell.size);
+    if (cell.styled) out.append(text, cell.color, cell.modifier);
+    else out.appendPlain(text);
+  }
+  cursor_col = end;
+}
+
+/// Writes the runs of cells that differ between two versions of a row.
+void Screen::diffRow(const row_t &before, const row_t &after, size_t row) {
+  static const Cell blank;
+  auto old_cell = [&] (size_t col) -> const Cell& { return col < before.size() ? before[col] : blank; };
+
+  size_t col = 0;
+  while (col < after.size()) {
+    if (after[col] == old_cell(col)) {
+      col++;
+      continue;
+    }
+    // Extend the run over changed cells and over short stretches of unchanged ones.
+    size_t run_end = col + 1, gap = 0;
+    for (size_t next_col = run_end; next_col < after.size() and gap <= MAX_GAP; next_col++) {
+      if (after[next_col] == old_cell(next_col)) {
+        gap++;
+      } else {
+        run_end = next_col + 1;
+        gap = 0;
+      }
+    }
+    moveTo(row, col);
+    writeCells(after, col, run_end);
+    col = run_end;
+  }
+
+  if (before.size() > after.size()) {
+    // Erasing uses the current background, so the style is cleared first.
+    moveTo(row, after.size());
+    out.resetStyle();
+    out.appendControl("\33[K");
+  }
+}
+
+/**
+ * @brief Returns what must be written to the terminal to replace the last frame with a new one
+ * 
+ * The first frame is written as is. The following ones only rewrite the cells that changed.
+ * 
+ * @param frame The rendered frame
+ * @return The bytes to write, valid until the next call
+ */
+std::string_view Screen::update(std::string_view frame) {
+  out.clear();
+  layout(frame, next);
+
+  if (not drawn) {
+    out.appendControl(frame);
+    drawn = true;
+    // Rendered frames end with a line break, which leaves the cursor below the last row.
+    cursor_row = next.size();
+    cursor_col = 0;
+    std::swap(shown, next);
+    return out.finish();
+  }
+
+  // Start from the saved position, in case something else moved the cursor.
+  out.appendControl("\33[u");
+  cursor_row = cursor_col = 0;
+  for (size_t row = 0; row < next.size(); row++) {
+    diffRow(row < shown.size() ? shown[row] : row_t{}, next[row], row);
+  }
+  if (shown.size() > next.size()) {
+    moveTo(next.size(), 0);
+    out.resetStyle();
+    out.appendControl("\33[J");
+  }
+  std::swap(shown, next);
+  return out.finish();
+}
+
+/// Returns what must be written to leave the cursor below the last frame.
+std::string_view Screen::finish() {
+  out.clear();
+  if (drawn) moveTo(shown.size(), 0);
+  return out.finish();
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string_view>        // std::string_view
+#include <vector>             // std::vector
+#include <cstdint>            // uint8_t
+#include "libs/text_color.h"  // StyledBuffer, color_t, mod_t
+
+/**
+ * @brief Keeps what is on the terminal and turns each new frame into the changes it needs.
+ * 
+ * Frames are given as the text produced by Frame::render: plain characters, line breaks,
+ * tabs and the SGR sequences emitted by StyledBuffer. The text is laid out into a grid of
+ * cells (a character and its style), which is compared with the grid of the previous
+ * frame. Only the runs of cells that differ are written, after a cursor movement.
+ * 
+ * Positions are relative to the cursor position saved (with "\033[s") before the first
+ * frame, and every line is assumed to fit in the terminal's width.
+ */
+class Screen {
+  /// @brief One character on the terminal and its style.
+  struct Cell {
+    char text[4] = {' '};               ///< UTF-8 bytes of the character
+    uint8_t size = 1;                   ///< Number of bytes in text
+    bool styled = false;                ///< Whether color and modifier apply
+    color_t color = Colors::WHITE;
+    mod_t modifier = Modifiers::REGULAR;
+
+    bool operator==(const Cell &other) const;
+  };
+  using row_t = std::vector<Cell>;
+
+  static constexpr size_t TAB_WIDTH = 8;
+  static constexpr size_t MAX_GAP = 4;  ///< Unchanged cells rewritten rather than skipped with a cursor movement
+
+  std::vector<row_t> shown;   ///< Cells of the last frame written
+  std::vector<row_t> next;    ///< Cells of the frame being written
+  StyledBuffer out;           ///< Bytes to write to the terminal
+  bool drawn = false;         ///< Whether a frame was written already
+  size_t cursor_row = 0;      ///< Cursor position, relative to the saved one
+  size_t cursor_col = 0;
+
+  static void layout(std::string_view frame, std::vector<row_t> &grid);
+  void moveTo(size_t row, size_t col);
+  void writeCells(const row_t &row, size_t begin, size_t end);
+  void diffRow(const row_t &before, const row_t &after, size_t row);
+
+  public:
+  std::string_view update(std::string_view frame);
+  std::string_view finish();
+  /// Forgets what is on the terminal, so the next frame is written whole (e.g. after it was cleared).
+  void reset() { drawn = false; }
+};
@@ -0,0 +1,73 @@
+#include "symbol_table.h"
+
+#include <cstring>  // std::memcpy
+#include <mutex>    // std::unique_lock, std::shared_lock
+#include <atomic>   // std::memory_order
+
+/// Copies text into the arena and returns a view of the copy.
+std::string_view SymbolTable::store(std::string_view text) {
+  if (text.empty()) return {};
+
+  char *dest;
+  if (text.size() > CHUNK_SIZE / 4) {
+    // Long strings get a chunk of their own, so the current chunk keeps its free space.
+    chunks.push_back(std::make_unique<char[]>(text.size()));
+    dest = chunks.back().get();
+  } else {
+    if (free_bytes < text.size()) {
+      chunks.push_back(std::make_unique<char[]>(CHUNK_SIZE));
+      cursor = chunks.back().get();
+      free_bytes = CHUNK_SIZE;
+    }
+    dest = cursor;
+    cursor += text.size();
+    free_bytes -= text.size();
+  }
+  std::memcpy(dest, text.data(), text.size());
+  return {dest, text.size()};
+}
+
+/// Returns the ID of text, adding it to the table if it was not there yet.
+symbol_t SymbolTable::intern(std::string_view text) {
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = ids.find(text);
+    if (it != ids.end()) return it->second;
+  }
+
+  std::unique_lock<std::shared_mutex> lock(mutex);
+  // Another thread may have added it between the two locks.
+  auto it = ids.find(text);
+  if (it != ids.end()) return it->second;
+
+  std::string_view stored = store(text);
+  symbol_t id = n_names.load(std::memory_order_relaxed);
+  auto [segment, index] = locate(id);
+  if (index == 0) {
+    segments[segment].store(new std::string_view[FIRST_SEGMENT << segment], std::memory_order_release);
+  }
+  segments[segment].load(std::memory_order_relaxed)[index] = stored;
+  n_names.store(id + 1, std::memory_order_release);
+  ids.emplace(stored, id);
+  return id;
+}
+
+SymbolTable::~SymbolTable() {
+  for (auto &segment : segments) delete[] segment.load();
+}
+
+/**
+ * @brief Returns the string a symbol stands for, without taking any lock
+ * 
+ * The ID must come from intern(), directly or through something that synchronizes with
+ * the thread that interned it (e.g. a queue of frames), as every ID used by a frame does.
+ */
+std::string_view SymbolTable::name(symbol_t id) const {
+  auto [segment, index] = locate(id);
+  return segments[segment].load(std::memory_order_acquire)[index];
+}
+
+/// Returns the number of distinct symbols.
+size_t SymbolTable::size() const {
+  return n_names.load(std::memory_order_acquire);
+}
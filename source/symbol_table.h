@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string_view>      // std::string_view
+#include <string>           // std::string
+#include <vector>           // std::vector
+#include <memory>           // std::unique_ptr
+#include <unordered_map>    // std::unordered_map
+#include <shared_mutex>     // std::shared_mutex
+#include <atomic>           // std::atomic
+#include <cstdint>          // uint32_t
+#include <utility>          // std::pair
+#include <bit>              // std::bit_width
+
+using symbol_t = uint32_t;
+
+/**
+ * @brief Interns strings, giving each distinct string a dense integer ID.
+ * 
+ * The characters of every interned string are copied once into an arena owned by the
+ * table, so views returned by name() stay valid for the table's whole lifetime.
+ * The table can be used from several threads at once.
+ * 
+ * Interning takes a lock, but looking a name up does not, since every rendered bar does
+ * it, even while another thread interns the strings of the frames being read. Names are
+ * kept in segments that never move once allocated (each one twice as large as the one
+ * before), so reading one while another is added needs no lock.
+ */
+class SymbolTable {
+  static constexpr size_t CHUNK_SIZE = 64 * 1024;   ///< Size of each arena chunk
+  static constexpr size_t FIRST_SEGMENT = 1024;       ///< Names in the first segment, each next one holds twice as many
+  static constexpr size_t MAX_SEGMENTS = 23;          ///< Enough segments for every symbol_t
+
+  std::vector<std::unique_ptr<char[]>> chunks;        ///< Arena holding the characters of every symbol
+  char *cursor = nullptr;                             ///< Next free byte of the current chunk
+  size_t free_bytes = 0;                              ///< Bytes left in the current chunk
+  std::atomic<std::string_view*> segments[MAX_SEGMENTS] = {}; ///< Symbol names, indexed by ID
+  std::atomic<size_t> n_names = 0;                    ///< Number of symbols
+  std::unordered_map<std::string_view, symbol_t> ids; ///< Symbol IDs, keyed by name
+  mutable std::shared_mutex mutex;
+
+  std::string_view store(std::string_view text);
+  /// Segment holding the name of a symbol, and the name's index in it.
+  static std::pair<size_t, size_t> locate(symbol_t id) {
+    size_t segment = std::bit_width(id / FIRST_SEGMENT + 1) - 1;
+    return {segment, id - FIRST_SEGMENT * ((size_t(1) << segment) - 1)};
+  }
+
+  public:
+  SymbolTable() = default;
+  ~SymbolTable();
+  SymbolTable(const SymbolTable&) = delete;
+  SymbolTable &operator=(const SymbolTable&) = delete;
+
+  symbol_t intern(std::string_view text);
+  std::string_view name(symbol_t id) const;
+  size_t size() const;
+};
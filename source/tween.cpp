@@ -0,0 +1,71 @@
+#include "tween.h"
+
+#include <cmath>  // std::round, std::trunc
+
+/**
+ * @brief Makes the last frame pushed the start of the tween and next its target
+ * 
+ * Bars that were already missing from the previous target are forgotten, since they
+ * finished shrinking out of the chart.
+ * 
+ * @param next The frame that follows the last one pushed
+ * 
+ * Time Complexity: O(n) where n is the number of bars of both frames
+ */
+void Tweener::push(const Frame &next) {
+  size_t kept = 0;
+  for (Entity &entity : entities) {
+    if (not entity.present) {
+      slot_of[entity.label] = NO_SLOT;
+      continue;
+    }
+    entity.from = entity.to;
+    entity.to = 0;
+    entity.present = false;
+    slot_of[entity.label] = kept;
+    entities[kept++] = entity;
+  }
+  entities.resize(kept);
+
+  const vector<symbol_t> &labels = next.getLabels();
+  const vector<symbol_t> &categories = next.getCategories();
+  const vector<value_t> &values = next.getValues();
+  for (size_t i = 0; i < labels.size(); i++) {
+    if (labels[i] >= slot_of.size()) slot_of.resize(labels[i] + 1, NO_SLOT);
+    uint32_t &slot = slot_of[labels[i]];
+    if (slot == NO_SLOT) {
+      slot = entities.size();
+      entities.push_back({labels[i], categories[i], 0, values[i], true});
+    } else {
+      entities[slot].category = categories[i];
+      entities[slot].to = values[i];
+      entities[slot].present = true;
+    }
+  }
+
+  // In-between frames still show the start frame's timestamp.
+  symbol_t start_timestamp = target_timestamp;
+  target_timestamp = next.getTimestamp();
+  tween.clearBars();
+  tween.copyMeta(next);
+  tween.setTimestamp(start_timestamp);
+}
+
+/**
+ * @brief Makes the frame at some point between the start and the target frames
+ * 
+ * @param t How far from the start frame (0) to the target frame (1)
+ * @return The in-between frame, valid until the next call
+ * 
+ * Time Complexity: O(n) where n is the number of bars of both frames
+ */
+Frame &Tweener::at(double t) {
+  tween.clearBars();
+  for (const Entity &entity : entities) {
+    value_t value = entity.from + (entity.to - entity.from) * t;
+    // Series of whole numbers stay whole in between.
+    if (std::trunc(entity.from) == entity.from and std::trunc(entity.to) == entity.to) value = std::round(value);
+    tween.addBar(entity.label, entity.category, value);
+  }
+  return tween;
+}
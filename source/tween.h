@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>          // std::vector
+#include <cstdint>         // uint32_t
+#include "barchart.h"      // Frame
+#include "symbol_table.h"  // symbol_t
+
+/**
+ * @brief Synthesizes the in-between frames of two consecutive frames.
+ * 
+ * Frames are pushed in order, and each one becomes the target of the tween while the
+ * previous one becomes its start. Bars are matched by label: a bar's value is interpolated
+ * linearly between its value in both frames, so bars grow, shrink and overtake each other
+ * smoothly. Bars missing from one of the frames count as 0 there, so they grow in from
+ * nothing or shrink out of the chart.
+ * 
+ * Only the values of the two frames are kept and a single Frame is reused for every
+ * in-between frame, so tweening costs O(n) memory no matter how many frames are made.
+ * 
+ * Usage:
+ * ```
+ *      tweener.push(frame_a);
+ *      tweener.push(frame_b);
+ *      Frame &halfway = tweener.at(0.5);
+ * ```
+ */
+class Tweener {
+  /// @brief A bar of the start or target frame.
+  struct Entity {
+    symbol_t label;
+    symbol_t category;
+    value_t from;   ///< Value in the start frame
+    value_t to;     ///< Value in the target frame
+    bool present;   ///< Whether the target frame has this bar
+  };
+
+  static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+  std::vector<Entity> entities;   ///< Bars of both frames
+  std::vector<uint32_t> slot_of;  ///< Position in entities of each label, or NO_SLOT
+  Frame tween;                    ///< The last frame made by at()
+  symbol_t target_timestamp = 0;  ///< Timestamp of the target frame
+
+  public:
+  void push(const Frame &next);
+  Frame &at(double t);
+};